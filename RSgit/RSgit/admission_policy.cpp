@@ -0,0 +1,34 @@
+#include "admission_policy.h"
+
+admission_policy::admission_policy()
+{
+	//no limits
+	max_wait = std::numeric_limits<double>::infinity();
+	max_detour_ratio = std::numeric_limits<double>::infinity();
+	max_planned_stops = std::numeric_limits<ULL>::max();
+}
+
+admission_policy::~admission_policy()
+{
+	//dtor
+}
+
+//set the limits (infinity and max: no limit), a transporter must have room for at least one customer
+void admission_policy::set_limits(double param_max_wait, double param_max_detour_ratio, ULL param_max_planned_stops)
+{
+	assert(param_max_wait >= 0 && param_max_detour_ratio >= 1 && param_max_planned_stops >= 2);
+
+	max_wait = param_max_wait;
+	max_detour_ratio = param_max_detour_ratio;
+	max_planned_stops = param_max_planned_stops;
+}
+
+//check the offer for a request against the limits (all conditions checked to within epsilon precision, as in the dispatcher)
+admission_decision admission_policy::check_offer(double request_time, double pickup_time, double dropoff_time, double direct_trip_time)
+{
+	if (pickup_time - request_time > max_wait + MACRO_EPSILON)
+		return(rejected_wait);
+	if (dropoff_time - pickup_time > max_detour_ratio * direct_trip_time + MACRO_EPSILON)
+		return(rejected_detour);
+	return(admitted);
+}
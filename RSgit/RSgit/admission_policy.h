@@ -0,0 +1,54 @@
+#ifndef ADMISSION_POLICY_H
+#define ADMISSION_POLICY_H
+
+#include <cstdint>
+#include <limits>
+
+#include <cassert>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+#ifndef _EPSILON
+#define MACRO_EPSILON 0.000000000001
+#define _EPSILON
+#endif
+
+//outcome of the admission control of a request (see ridesharing_sim::handle_request)
+enum admission_decision
+{
+	admitted,
+	rejected_full_schedules,	//no transporter has room for two more stops (rejected before the search)
+	rejected_no_offer,			//no transporter can pick up within the maximal wait and has room for two more stops
+	rejected_wait,				//the best offer picks up later than the maximal wait
+	rejected_detour				//the best offer takes longer than the maximal detour ratio times the direct trip
+};
+
+//limits of the admission control: requests are rejected instead of growing the schedules without bound when the fleet is saturated
+//transporters check the wait and the schedule length in O(1) before their insertion search (see transporter::best_offer), the offer found is checked here
+class admission_policy
+{
+public:
+	admission_policy();
+	virtual ~admission_policy();
+
+	void set_limits(double param_max_wait, double param_max_detour_ratio, ULL param_max_planned_stops);
+
+	double get_max_wait() { return(max_wait); }
+	double get_max_detour_ratio() { return(max_detour_ratio); }
+	ULL get_max_planned_stops() { return(max_planned_stops); }
+
+	admission_decision check_offer(double request_time, double pickup_time, double dropoff_time, double direct_trip_time);
+
+protected:
+
+private:
+	double max_wait;			//from the request to the pickup
+	double max_detour_ratio;	//time from pickup to dropoff over the direct trip time
+	ULL max_planned_stops;		//of a transporter, including the new pickup and dropoff
+};
+
+#endif // ADMISSION_POLICY_H
@@ -0,0 +1,160 @@
+#include "assignment_solver.h"
+
+assignment_solver::assignment_solver()
+{
+	number_of_rows = 0;
+	number_of_columns = 0;
+	unassigned_cost = 0;
+}
+
+assignment_solver::~assignment_solver()
+{
+	//dtor
+}
+
+//start a new problem
+void assignment_solver::reset(ULL param_number_of_rows, ULL param_number_of_columns)
+{
+	number_of_rows = param_number_of_rows;
+	number_of_columns = param_number_of_columns;
+
+	if (row_edges.size() < number_of_rows)
+		row_edges.resize(number_of_rows);
+	for (ULL row = 0; row < number_of_rows; ++row)
+		row_edges[row].clear();
+}
+
+void assignment_solver::add_edge(ULL row, ULL column, double cost)
+{
+	assert(row < number_of_rows && column < number_of_columns);
+	row_edges[row].push_back(std::make_pair(column, cost));
+}
+
+//assign the rows one after the other along shortest augmenting paths
+void assignment_solver::solve()
+{
+	ULL total_columns = number_of_columns + number_of_rows;
+
+	//cost of leaving a row unassigned: larger than the difference of the total cost of any two assignments
+	double min_cost = std::numeric_limits<double>::max();
+	double max_cost = std::numeric_limits<double>::lowest();
+	for (ULL row = 0; row < number_of_rows; ++row)
+	{
+		for (std::pair<ULL, double>& e : row_edges[row])
+		{
+			min_cost = std::min(min_cost, e.second);
+			max_cost = std::max(max_cost, e.second);
+		}
+	}
+	if (min_cost > max_cost)
+		min_cost = max_cost = 0;
+	unassigned_cost = max_cost + (max_cost - min_cost + 1) * (number_of_rows + 1);
+
+	row_potential.assign(number_of_rows, 0);
+	column_potential.assign(total_columns, 0);
+	row_column.assign(number_of_rows, -1);
+	column_row.assign(total_columns, -1);
+
+	distance.assign(total_columns, std::numeric_limits<double>::max());
+	predecessor_row.assign(total_columns, 0);
+	finalized.assign(total_columns, false);
+
+	for (ULL row = 0; row < number_of_rows; ++row)
+		augment(row);
+}
+
+//assign a new row: shortest path (reduced costs) from the row to an unassigned column, then swap the assignments along the path
+void assignment_solver::augment(ULL row)
+{
+	//column potentials only decrease, so all reduced costs of the new row are non-negative with its minimal cost as potential
+	row_potential[row] = unassigned_cost;
+	for (std::pair<ULL, double>& e : row_edges[row])
+		row_potential[row] = std::min(row_potential[row], e.second);
+
+	touched_columns.clear();
+	finalized_columns.clear();
+	while (!column_queue.empty())
+		column_queue.pop();
+
+	//relax all edges of a row that is reached at the given distance
+	auto scan_row = [this](ULL i, double row_distance)
+	{
+		auto relax = [this, i, row_distance](ULL column, double cost)
+		{
+			if (finalized[column])
+				return;
+			double d = row_distance + cost - row_potential[i] - column_potential[column];
+			if (d < distance[column])
+			{
+				if (distance[column] == std::numeric_limits<double>::max())
+					touched_columns.push_back(column);
+				distance[column] = d;
+				predecessor_row[column] = i;
+				column_queue.push(std::make_pair(d, column));
+			}
+		};
+
+		for (std::pair<ULL, double>& e : row_edges[i])
+			relax(e.first, e.second);
+		relax(number_of_columns + i, unassigned_cost);
+	};
+
+	scan_row(row, 0);
+
+	ULL end_column = 0;
+	double path_distance = 0;
+	while (true)
+	{
+		//the private column of the row is always reachable
+		assert(!column_queue.empty());
+
+		double d = column_queue.top().first;
+		ULL column = column_queue.top().second;
+		column_queue.pop();
+		if (finalized[column] || d > distance[column])
+			continue;
+
+		finalized[column] = true;
+		finalized_columns.push_back(column);
+
+		if (column_row[column] < 0)
+		{
+			end_column = column;
+			path_distance = d;
+			break;
+		}
+
+		//continue from the row that is currently assigned to the column (assigned edges have reduced cost 0)
+		scan_row(column_row[column], d);
+	}
+
+	//update the potentials, so that the reduced costs stay non-negative and the edges along the path have reduced cost 0
+	row_potential[row] += path_distance;
+	for (ULL column : finalized_columns)
+	{
+		if (column == end_column)
+			continue;
+		column_potential[column] -= path_distance - distance[column];
+		row_potential[column_row[column]] += path_distance - distance[column];
+	}
+
+	//swap the assignments along the path
+	ULL column = end_column;
+	while (true)
+	{
+		ULL i = predecessor_row[column];
+		LL previous_column = row_column[i];
+		row_column[i] = column;
+		column_row[column] = i;
+		if (i == row)
+			break;
+		column = previous_column;
+	}
+
+	//reset the search data of all columns that were reached
+	for (ULL c : touched_columns)
+	{
+		distance[c] = std::numeric_limits<double>::max();
+		finalized[c] = false;
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef ASSIGNMENT_SOLVER_H
+#define ASSIGNMENT_SOLVER_H
+
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <limits>
+#include <functional>
+
+#include <cassert>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+//minimum cost assignment on a sparse bipartite graph (e.g. requests to transporters)
+//each row and each column is assigned at most once, rows without a column stay unassigned
+//first maximizes the number of assigned rows, then minimizes the total cost of the assigned edges (exact)
+//
+//shortest augmenting paths with potentials (Hungarian method on sparse edges): every row has an additional private column with a cost
+//larger than any difference between assignments, rows assigned to it are unassigned
+class assignment_solver
+{
+public:
+	assignment_solver();
+	virtual ~assignment_solver();
+
+	void reset(ULL param_number_of_rows, ULL param_number_of_columns);	//remove all edges (memory is kept)
+	void add_edge(ULL row, ULL column, double cost);
+	void solve();
+
+	LL get_assigned_column(ULL row) { return(row_column[row] < (LL)number_of_columns ? row_column[row] : -1); }	//-1: unassigned
+
+protected:
+
+private:
+	void augment(ULL row);
+
+	ULL number_of_rows;
+	ULL number_of_columns;		//without the private columns of the rows (column number_of_columns + row)
+
+	std::vector< std::vector< std::pair<ULL, double> > > row_edges;	//column and cost
+	double unassigned_cost;
+
+	//potentials (reduced cost of an edge: cost - row_potential - column_potential >= 0, = 0 for assigned edges)
+	std::vector<double> row_potential;
+	std::vector<double> column_potential;
+	std::vector<LL> row_column;
+	std::vector<LL> column_row;
+
+	//shortest path search
+	std::vector<double> distance;
+	std::vector<ULL> predecessor_row;
+	std::vector<bool> finalized;
+	std::vector<ULL> touched_columns;
+	std::vector<ULL> finalized_columns;
+	std::priority_queue< std::pair<double, ULL>, std::vector< std::pair<double, ULL> >, std::greater< std::pair<double, ULL> > > column_queue;
+};
+
+#endif // ASSIGNMENT_SOLVER_H
@@ -6,8 +6,9 @@ customer::customer(ULL param_origin, ULL param_destination, double param_time, t
 	//set allowed delay (relative to remaining time until promised stop)
 	//values < 1 means no delay at all
 	//set to e.g. 1.10 to allow a 10% delay relative to (promised - current) time
-	allowed_pickup_delay = 0;
-	allowed_dropoff_delay = 0;
+	//given by the type of the transporter (see fleet_type_table)
+	allowed_pickup_delay = t.get_allowed_pickup_delay();
+	allowed_dropoff_delay = t.get_allowed_dropoff_delay();
 }
 
 customer::~customer()
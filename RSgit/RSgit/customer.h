@@ -2,6 +2,7 @@
 #define CUSTOMER_H
 
 #include <cassert>
+#include <cstdint>
 
 #ifndef _INTEGER_TYPES
 #define ULL uint64_t
@@ -14,6 +15,9 @@
 #define _EPSILON
 #endif
 
+//customers are referred to by the index of their slot in the customer_pool of the simulation
+typedef uint32_t customer_handle;
+
 #include "traffic_network.h"
 #include "transporter.h"
 
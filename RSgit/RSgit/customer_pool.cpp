@@ -0,0 +1,82 @@
+#include "customer_pool.h"
+
+//constructor, no customers and no retention
+customer_pool::customer_pool()
+{
+	retain_customers = false;
+	number_of_active_customers = 0;
+}
+
+customer_pool::~customer_pool()
+{
+	clear();
+}
+
+//store a new customer in a free slot (or a new one if all slots are in use)
+customer_handle customer_pool::add_customer(const customer& c)
+{
+	customer_handle h;
+
+	if (!free_handles.empty())
+	{
+		h = free_handles.back();
+		free_handles.pop_back();
+		customers[h] = c;
+	}
+	else {
+		//make sure the handle does not overflow
+		assert(customers.size() < std::numeric_limits<customer_handle>::max());
+
+		h = customers.size();
+		customers.push_back(c);
+	}
+
+	++number_of_active_customers;
+	return(h);
+}
+
+//customer was dropped off, either reuse the slot or keep the customer for later output
+void customer_pool::release_customer(customer_handle h)
+{
+	assert(h < customers.size() && number_of_active_customers > 0);
+
+	--number_of_active_customers;
+	if (retain_customers)
+		retained_customers.push_back(h);
+	else
+		free_handles.push_back(h);
+}
+
+//keep all customers that are served from now on
+void customer_pool::enable_retention()
+{
+	retain_customers = true;
+}
+
+//reuse the slots of customers that are served from now on (customers retained so far are kept)
+void customer_pool::disable_retention()
+{
+	retain_customers = false;
+}
+
+//print all retained customers, one line per trip
+//origin, destination, request time, offered pickup and dropoff time, actual pickup and dropoff time
+void customer_pool::print_trips(std::ostream& out)
+{
+	for (customer_handle h : retained_customers)
+	{
+		customer& c = customers[h];
+		out << c.get_origin() << '\t' << c.get_destination() << '\t' << c.get_request_time() << '\t'
+			<< c.get_offer_pickup_time() << '\t' << c.get_offer_dropoff_time() << '\t'
+			<< c.get_pickup_time() << '\t' << c.get_dropoff_time() << std::endl;
+	}
+}
+
+//remove all customers (e.g. to start a new simulation), the retention setting is kept
+void customer_pool::clear()
+{
+	customers.clear();
+	free_handles.clear();
+	retained_customers.clear();
+	number_of_active_customers = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef CUSTOMER_POOL_H
+#define CUSTOMER_POOL_H
+
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <iostream>
+
+#include <cassert>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+#include "customer.h"
+
+//storage for all customers of the simulation, customers are referred to by a 32-bit handle (index of their slot)
+//slots of served customers are reused for new customers, so no memory is allocated once enough slots exist
+//optionally, served customers are retained instead (e.g. to export all trips after the simulation)
+class customer_pool
+{
+public:
+	customer_pool();
+	virtual ~customer_pool();
+
+	customer_handle add_customer(const customer& c);	//returns the handle of the new customer
+	void release_customer(customer_handle h);			//customer was served, slot can be reused (unless customers are retained)
+	customer& get_customer(customer_handle h) { assert(h < customers.size()); return(customers[h]); }
+
+	void enable_retention();
+	void disable_retention();
+	bool is_retaining() { return(retain_customers); }
+
+	ULL get_number_of_active_customers() { return(number_of_active_customers); }
+	ULL get_number_of_slots() { return(customers.size()); }
+	const std::vector<customer_handle>& get_retained_customers() { return(retained_customers); }	//in order of their dropoff
+
+	void print_trips(std::ostream& out);	//one line per retained customer
+
+	void clear();
+
+protected:
+
+private:
+	std::vector<customer> customers;
+	std::vector<customer_handle> free_handles;
+
+	bool retain_customers;
+	std::vector<customer_handle> retained_customers;
+
+	ULL number_of_active_customers;
+};
+
+#endif // CUSTOMER_POOL_H
@@ -0,0 +1,50 @@
+#include "dispatch_instrumentation.h"
+
+std::mutex dispatch_work_counters::registry_mutex;
+std::vector< std::unique_ptr<dispatch_work_counters> > dispatch_work_counters::registry;
+
+dispatch_work_counters& dispatch_work_counters::operator+=(const dispatch_work_counters& other)
+{
+	transporters_evaluated += other.transporters_evaluated;
+	pickup_positions += other.pickup_positions;
+	dropoff_positions += other.dropoff_positions;
+	delay_check_iterations += other.delay_check_iterations;
+	bound_exits += other.bound_exits;
+	pickup_scan_exits += other.pickup_scan_exits;
+	return(*this);
+}
+
+dispatch_work_counters& dispatch_work_counters::operator-=(const dispatch_work_counters& other)
+{
+	transporters_evaluated -= other.transporters_evaluated;
+	pickup_positions -= other.pickup_positions;
+	dropoff_positions -= other.dropoff_positions;
+	delay_check_iterations -= other.delay_check_iterations;
+	bound_exits -= other.bound_exits;
+	pickup_scan_exits -= other.pickup_scan_exits;
+	return(*this);
+}
+
+//counters of the calling thread, registered on first use
+dispatch_work_counters& dispatch_work_counters::of_this_thread()
+{
+	thread_local dispatch_work_counters* counters = NULL;
+	if (counters == NULL)
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		registry.push_back(std::unique_ptr<dispatch_work_counters>(new dispatch_work_counters()));
+		counters = registry.back().get();
+	}
+	return(*counters);
+}
+
+//total work of all threads (the counters only grow, the work of a request is the difference before and after)
+dispatch_work_counters dispatch_work_counters::sum_of_all_threads()
+{
+	dispatch_work_counters sum;
+
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	for (std::unique_ptr<dispatch_work_counters>& counters : registry)
+		sum += *counters;
+	return(sum);
+}
@@ -0,0 +1,48 @@
+#ifndef DISPATCH_INSTRUMENTATION_H
+#define DISPATCH_INSTRUMENTATION_H
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+//optional counters of the work done by the dispatcher, only compiled in if DISPATCH_INSTRUMENTATION is defined (e.g. in the project settings)
+//otherwise COUNT_DISPATCH_WORK does nothing and no counting code is generated
+#ifdef DISPATCH_INSTRUMENTATION
+#define COUNT_DISPATCH_WORK(counter, amount) (dispatch_work_counters::of_this_thread().counter += (amount))
+#else
+#define COUNT_DISPATCH_WORK(counter, amount) ((void)0)
+#endif
+
+//work of transporter::best_offer, each thread counts into its own counters (best_offer runs on the dispatch threads as well)
+//the counters of all threads are summed after each request (see dispatch_statistics)
+struct dispatch_work_counters
+{
+	ULL transporters_evaluated;		//calls of best_offer (and offers of idle transporters evaluated together)
+	ULL pickup_positions;			//pickup positions tried
+	ULL dropoff_positions;			//insertions (pickup and dropoff position) compared
+	ULL delay_check_iterations;		//iterations of the loops over the stops of a schedule
+	ULL bound_exits;				//transporters skipped by the lower bound of their dropoff time
+	ULL pickup_scan_exits;			//pickup scans stopped before the end of the schedule
+
+	dispatch_work_counters() : transporters_evaluated(0), pickup_positions(0), dropoff_positions(0), delay_check_iterations(0), bound_exits(0), pickup_scan_exits(0) {};
+
+	dispatch_work_counters& operator+=(const dispatch_work_counters& other);
+	dispatch_work_counters& operator-=(const dispatch_work_counters& other);
+
+	static dispatch_work_counters& of_this_thread();
+	static dispatch_work_counters sum_of_all_threads();	//only while no other thread is counting (e.g. between dispatches)
+
+private:
+	//counters of every thread that counted so far (kept after the thread ends)
+	static std::mutex registry_mutex;
+	static std::vector< std::unique_ptr<dispatch_work_counters> > registry;
+};
+
+#endif // DISPATCH_INSTRUMENTATION_H
@@ -0,0 +1,109 @@
+#ifndef DISPATCH_OBJECTIVE_H
+#define DISPATCH_OBJECTIVE_H
+
+#include <cstdint>
+#include <cmath>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+#ifndef _EPSILON
+#define MACRO_EPSILON 0.000000000001
+#define _EPSILON
+#endif
+
+//objectives of the dispatcher, used as template parameter of transporter::best_offer and ridesharing_sim::find_best_offer
+//so that each objective is compiled into its own search without switching between objectives in the inner loops
+//
+//an objective ranks an insertion by a cost and a tie cost (both: lower is better), computed from
+//		request time, pickup time, dropoff time and the added driving time of the transporter
+//an insertion is better if its cost is lower (by more than epsilon), or the costs are equal within epsilon and the tie cost is lower (by more than epsilon)
+//remaining ties are broken as before: the transporter with the larger occupancy, then the last one in the order of the search
+//
+//dropoff_time_is_cost: the cost is the dropoff time, i.e. lower bounds for the dropoff time are lower bounds for the cost
+//		(allows the bound ordered search, the idle index, pruning of the parallel search and the linear time insertion in best_offer)
+
+enum dispatch_objective_type
+{
+	earliest_dropoff = 0,
+	minimal_wait = 1,
+	minimal_added_vehicle_time = 2,
+	weighted_cost = 3
+};
+
+//minimize the dropoff time, then maximize the pickup time (original dispatcher)
+struct earliest_dropoff_objective
+{
+	static const bool dropoff_time_is_cost = true;
+
+	static double cost(double, double, double dropoff_time, double) { return(dropoff_time); }
+	static double tie_cost(double, double pickup_time, double, double) { return(-pickup_time); }
+};
+
+//minimize the waiting time of the customer, then the dropoff time
+struct minimal_wait_objective
+{
+	static const bool dropoff_time_is_cost = false;
+
+	static double cost(double request_time, double pickup_time, double, double) { return(pickup_time - request_time); }
+	static double tie_cost(double, double, double dropoff_time, double) { return(dropoff_time); }
+};
+
+//minimize the additional driving time of the transporter, then the dropoff time
+struct minimal_added_vehicle_time_objective
+{
+	static const bool dropoff_time_is_cost = false;
+
+	static double cost(double, double, double, double added_vehicle_time) { return(added_vehicle_time); }
+	static double tie_cost(double, double, double dropoff_time, double) { return(dropoff_time); }
+};
+
+//minimize a weighted sum of waiting time, ride time and added driving time (integer weights, fixed at compile time), then the dropoff time
+template<LL wait_weight, LL ride_weight, LL vehicle_weight>
+struct weighted_cost_objective
+{
+	static const bool dropoff_time_is_cost = false;
+
+	static double cost(double request_time, double pickup_time, double dropoff_time, double added_vehicle_time) {
+		return(wait_weight * (pickup_time - request_time) + ride_weight * (dropoff_time - pickup_time) + vehicle_weight * added_vehicle_time);
+	}
+	static double tie_cost(double, double, double dropoff_time, double) { return(dropoff_time); }
+};
+
+//weights used for dispatch_objective_type weighted_cost
+typedef weighted_cost_objective<2, 1, 1> default_weighted_cost_objective;
+
+//comparison of two insertions by an objective
+template<class objective>
+struct objective_comparison
+{
+	//strictly better (not within epsilon)
+	static bool is_better(double request_time, double pickup_time, double dropoff_time, double added_vehicle_time, double other_pickup_time, double other_dropoff_time, double other_added_vehicle_time)
+	{
+		double c = objective::cost(request_time, pickup_time, dropoff_time, added_vehicle_time);
+		double other_c = objective::cost(request_time, other_pickup_time, other_dropoff_time, other_added_vehicle_time);
+		return(c < other_c - MACRO_EPSILON ||
+			(std::abs(c - other_c) <= MACRO_EPSILON && objective::tie_cost(request_time, pickup_time, dropoff_time, added_vehicle_time) < objective::tie_cost(request_time, other_pickup_time, other_dropoff_time, other_added_vehicle_time) - MACRO_EPSILON));
+	}
+
+	//lower cost (without epsilon)
+	static bool has_lower_cost(double request_time, double pickup_time, double dropoff_time, double added_vehicle_time, double other_pickup_time, double other_dropoff_time, double other_added_vehicle_time)
+	{
+		return(objective::cost(request_time, pickup_time, dropoff_time, added_vehicle_time) < objective::cost(request_time, other_pickup_time, other_dropoff_time, other_added_vehicle_time));
+	}
+
+	//equally good (within epsilon)
+	static bool is_equal(double request_time, double pickup_time, double dropoff_time, double added_vehicle_time, double other_pickup_time, double other_dropoff_time, double other_added_vehicle_time)
+	{
+		double c = objective::cost(request_time, pickup_time, dropoff_time, added_vehicle_time);
+		double other_c = objective::cost(request_time, other_pickup_time, other_dropoff_time, other_added_vehicle_time);
+		double t = objective::tie_cost(request_time, pickup_time, dropoff_time, added_vehicle_time);
+		double other_t = objective::tie_cost(request_time, other_pickup_time, other_dropoff_time, other_added_vehicle_time);
+		return(std::abs(c - other_c) <= MACRO_EPSILON && std::abs(t - other_t) <= MACRO_EPSILON);
+	}
+};
+
+#endif // DISPATCH_OBJECTIVE_H
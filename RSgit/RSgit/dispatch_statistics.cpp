@@ -0,0 +1,138 @@
+#include "dispatch_statistics.h"
+
+dispatch_statistics::dispatch_statistics()
+{
+	reset();
+}
+
+dispatch_statistics::~dispatch_statistics()
+{
+}
+
+//reset all statistics
+void dispatch_statistics::reset()
+{
+	transporters_evaluated.reset();
+	pickup_positions.reset();
+	dropoff_positions.reset();
+	delay_check_iterations.reset();
+	bound_exits.reset();
+	pickup_scan_exits.reset();
+	latency.reset();
+
+	latency_histogram.assign(64, 0);
+
+	load_bins.resize(10);
+	for (load_bin& b : load_bins)
+	{
+		b.transporters_evaluated.reset();
+		b.pickup_positions.reset();
+		b.dropoff_positions.reset();
+		b.latency.reset();
+		b.mean_planned_stops.reset();
+	}
+}
+
+//add the work and latency of one request
+void dispatch_statistics::measure_request(const dispatch_work_counters& work, ULL latency_nanoseconds, double fraction_of_busy_transporters, double mean_planned_stops)
+{
+	new_measurement(transporters_evaluated, work.transporters_evaluated);
+	new_measurement(pickup_positions, work.pickup_positions);
+	new_measurement(dropoff_positions, work.dropoff_positions);
+	new_measurement(delay_check_iterations, work.delay_check_iterations);
+	new_measurement(bound_exits, work.bound_exits);
+	new_measurement(pickup_scan_exits, work.pickup_scan_exits);
+	new_measurement(latency, latency_nanoseconds);
+
+	ULL bucket = 0;
+	while (bucket + 1 < latency_histogram.size() && (latency_nanoseconds >> (bucket + 1)) > 0)
+		++bucket;
+	++latency_histogram[bucket];
+
+	load_bin& b = load_bins[std::min((ULL)(fraction_of_busy_transporters * load_bins.size()), (ULL)load_bins.size() - 1)];
+	new_measurement(b.transporters_evaluated, work.transporters_evaluated);
+	new_measurement(b.pickup_positions, work.pickup_positions);
+	new_measurement(b.dropoff_positions, work.dropoff_positions);
+	new_measurement(b.latency, latency_nanoseconds);
+	new_measurement(b.mean_planned_stops, mean_planned_stops);
+}
+
+//output the statistics (average, standard deviation as in measurement_collector), histogram and load bins only in the readable format
+void dispatch_statistics::print(std::ofstream& out, bool readable)
+{
+	if (!readable)
+	{
+		transporters_evaluated.print(out);
+		pickup_positions.print(out);
+		dropoff_positions.print(out);
+		delay_check_iterations.print(out);
+		bound_exits.print(out);
+		pickup_scan_exits.print(out);
+		latency.print(out);
+
+		out << std::endl;
+	}
+	else
+	{
+		out << "DISPATCH WORK PER REQUEST" << std::endl << std::endl;
+
+		out << "transporters_evaluated: " << std::endl;
+		transporters_evaluated.print(out);
+		out << std::endl;
+
+		out << "pickup_positions: " << std::endl;
+		pickup_positions.print(out);
+		out << std::endl;
+
+		out << "dropoff_positions: " << std::endl;
+		dropoff_positions.print(out);
+		out << std::endl;
+
+		out << "delay_check_iterations: " << std::endl;
+		delay_check_iterations.print(out);
+		out << std::endl;
+
+		out << "bound_exits: " << std::endl;
+		bound_exits.print(out);
+		out << std::endl;
+
+		out << "pickup_scan_exits: " << std::endl;
+		pickup_scan_exits.print(out);
+		out << std::endl;
+
+		out << "latency (ns): " << std::endl;
+		latency.print(out);
+		out << std::endl;
+
+		out << std::endl << "latency histogram (from ns, requests): " << std::endl;
+		ULL last_bucket = 0;
+		for (ULL bucket = 0; bucket < latency_histogram.size(); ++bucket)
+			if (latency_histogram[bucket] > 0)
+				last_bucket = bucket;
+		for (ULL bucket = 0; bucket <= last_bucket; ++bucket)
+			out << (bucket == 0 ? 0 : (ULL)1 << bucket) << '\t' << latency_histogram[bucket] << std::endl;
+
+		out << std::endl << "by fraction of busy transporters (from, requests, transporters_evaluated, pickup_positions, dropoff_positions, latency (ns), mean planned stops of busy transporters): " << std::endl;
+		for (ULL bin = 0; bin < load_bins.size(); ++bin)
+		{
+			load_bin& b = load_bins[bin];
+			if (b.latency.n == 0)
+				continue;
+			out << bin / (double)load_bins.size() << '\t' << b.latency.n << '\t' << b.transporters_evaluated.av << '\t' << b.pickup_positions.av << '\t' << b.dropoff_positions.av << '\t' << b.latency.av << '\t' << b.mean_planned_stops.av << std::endl;
+		}
+
+		out << std::endl;
+	}
+}
+
+//running average and variance (as in measurement_collector)
+void dispatch_statistics::new_measurement(measure& m, long double val)
+{
+	long double delta1, delta2;
+
+	m.n += 1;
+	delta1 = val - m.av;
+	m.av += delta1 / m.n;
+	delta2 = val - m.av;
+	m.stddev += delta1 * delta2;
+}
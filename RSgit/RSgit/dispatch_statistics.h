@@ -0,0 +1,59 @@
+#ifndef DISPATCH_STATISTICS_H
+#define DISPATCH_STATISTICS_H
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <vector>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+#include "measurement_collector.h"
+#include "dispatch_instrumentation.h"
+
+//work and latency of the dispatcher per request (see dispatch_instrumentation.h), printed with the measurements of the simulation
+//the work is also averaged separately by the load of the fleet at the time of the request (fraction of busy transporters, in bins of 10%),
+//together with the mean schedule length of the busy transporters, to relate the search effort to load and schedule length
+class dispatch_statistics
+{
+public:
+	dispatch_statistics();
+	virtual ~dispatch_statistics();
+
+	void reset();
+	void measure_request(const dispatch_work_counters& work, ULL latency_nanoseconds, double fraction_of_busy_transporters, double mean_planned_stops);
+	void print(std::ofstream& out, bool readable = false);
+
+protected:
+
+private:
+	measure transporters_evaluated;
+	measure pickup_positions;
+	measure dropoff_positions;
+	measure delay_check_iterations;
+	measure bound_exits;
+	measure pickup_scan_exits;
+	measure latency;				//nanoseconds
+
+	//latency histogram: bucket b counts latencies of at least 2^b and less than 2^(b+1) nanoseconds (bucket 0 also counts 0)
+	std::vector< ULL > latency_histogram;
+
+	//by load
+	struct load_bin
+	{
+		measure transporters_evaluated;
+		measure pickup_positions;
+		measure dropoff_positions;
+		measure latency;
+		measure mean_planned_stops;
+	};
+	std::vector< load_bin > load_bins;
+
+	void new_measurement(measure& m, long double val);
+};
+
+#endif // DISPATCH_STATISTICS_H
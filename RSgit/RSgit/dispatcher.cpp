@@ -0,0 +1,45 @@
+#include "dispatcher.h"
+#include "ridesharing_sim.h"
+
+dispatcher::dispatcher()
+{
+
+}
+
+dispatcher::~dispatcher()
+{
+	//dtor
+}
+
+//constructor, dispatcher with a fixed objective
+insertion_dispatcher::insertion_dispatcher(dispatch_objective_type param_objective)
+{
+	objective = param_objective;
+}
+
+insertion_dispatcher::~insertion_dispatcher()
+{
+	//dtor
+}
+
+//best offer of all transporters for the objective of this dispatcher
+offer insertion_dispatcher::find_offer(ridesharing_sim& sim, ULL request_origin, ULL request_destination, double request_time)
+{
+	return(sim.find_best_offer(request_origin, request_destination, request_time, objective));
+}
+
+//name of the dispatcher (e.g. for the benchmark output)
+std::string insertion_dispatcher::get_name()
+{
+	switch (objective)
+	{
+	case minimal_wait:
+		return("insertion_minimal_wait");
+	case minimal_added_vehicle_time:
+		return("insertion_minimal_added_vehicle_time");
+	case weighted_cost:
+		return("insertion_weighted_cost");
+	default:
+		return("insertion_earliest_dropoff");
+	}
+}
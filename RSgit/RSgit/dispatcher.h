@@ -0,0 +1,53 @@
+#ifndef DISPATCHER_H
+#define DISPATCHER_H
+
+#include <string>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+#ifndef _EPSILON
+#define MACRO_EPSILON 0.000000000001
+#define _EPSILON
+#endif
+
+#include "transporter.h"
+#include "dispatch_objective.h"
+
+class ridesharing_sim;
+
+//interface of a dispatcher: receives a request and the state of the fleet (the simulation) and returns the offer for the request
+//the simulation assigns the customer to the transporter of the offer (see ridesharing_sim::handle_request)
+class dispatcher
+{
+public:
+	dispatcher();
+	virtual ~dispatcher();
+
+	virtual offer find_offer(ridesharing_sim& sim, ULL request_origin, ULL request_destination, double request_time) = 0;
+	virtual std::string get_name() = 0;
+};
+
+//reference dispatcher: insert the request into the schedule of the transporter with the best offer (see transporter::best_offer)
+//uses the search settings of the simulation (bound ordered search, idle index, threads) with its own objective
+class insertion_dispatcher : public dispatcher
+{
+public:
+	insertion_dispatcher(dispatch_objective_type param_objective = earliest_dropoff);
+	virtual ~insertion_dispatcher();
+
+	virtual offer find_offer(ridesharing_sim& sim, ULL request_origin, ULL request_destination, double request_time);
+	virtual std::string get_name();
+
+	dispatch_objective_type get_objective() { return(objective); }
+
+protected:
+
+private:
+	dispatch_objective_type objective;
+};
+
+#endif // DISPATCHER_H
@@ -0,0 +1,68 @@
+#include "fleet_type_table.h"
+
+fleet_type_table::fleet_type_table()
+{
+	//default type
+	add_type(transporter_type("default", 1, -1, 0, 0));
+}
+
+fleet_type_table::~fleet_type_table()
+{
+	//dtor
+}
+
+//add a type at the end of the table
+ULL fleet_type_table::add_type(const transporter_type& t)
+{
+	assert(t.velocity > 0 && t.allowed_pickup_delay >= 0 && t.allowed_dropoff_delay >= 0);
+
+	types.push_back(t);
+	return(types.size() - 1);
+}
+
+//replace the table by the types read from the stream, the table is left unchanged if a line cannot be read
+bool fleet_type_table::load(std::istream& in)
+{
+	std::vector< transporter_type > loaded_types;
+
+	std::string line;
+	while (std::getline(in, line))
+	{
+		std::istringstream fields(line);
+		std::string name;
+		if (!(fields >> name) || name[0] == '#')
+			continue;
+
+		double velocity;
+		LL capacity;
+		double allowed_pickup_delay;
+		double allowed_dropoff_delay;
+		if (!(fields >> velocity >> capacity >> allowed_pickup_delay >> allowed_dropoff_delay) || velocity <= 0 || allowed_pickup_delay < 0 || allowed_dropoff_delay < 0)
+			return(false);
+
+		loaded_types.push_back(transporter_type(name, velocity, capacity, allowed_pickup_delay, allowed_dropoff_delay));
+	}
+
+	if (loaded_types.empty())
+		return(false);
+
+	types.swap(loaded_types);
+	return(true);
+}
+
+//read the table from a file (see above)
+bool fleet_type_table::load(std::string filename)
+{
+	std::ifstream in(filename.c_str());
+	if (!in)
+		return(false);
+	return(load(in));
+}
+
+//output the table in the format read by load
+void fleet_type_table::print(std::ofstream& out)
+{
+	out << "# name velocity capacity allowed_pickup_delay allowed_dropoff_delay" << std::endl;
+	for (transporter_type& t : types)
+		out << t.name << '\t' << t.velocity << '\t' << t.capacity << '\t' << t.allowed_pickup_delay << '\t' << t.allowed_dropoff_delay << std::endl;
+}
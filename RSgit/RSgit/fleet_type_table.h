@@ -0,0 +1,66 @@
+#ifndef FLEET_TYPE_TABLE_H
+#define FLEET_TYPE_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <cassert>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+#ifndef _EPSILON
+#define MACRO_EPSILON 0.000000000001
+#define _EPSILON
+#endif
+
+//parameters of one type of transporter (see transporter::init_by_type)
+struct transporter_type
+{
+	std::string name;
+	double velocity;
+	LL capacity;					//negative value --> infinite capacity
+	double allowed_pickup_delay;	//allowed delay of the customers of this type (see customer)
+	double allowed_dropoff_delay;
+
+	transporter_type(std::string param_name, double param_velocity, LL param_capacity, double param_allowed_pickup_delay, double param_allowed_dropoff_delay)
+		: name(param_name),
+		velocity(param_velocity),
+		capacity(param_capacity),
+		allowed_pickup_delay(param_allowed_pickup_delay),
+		allowed_dropoff_delay(param_allowed_dropoff_delay)
+	{};
+};
+
+//table of the transporter types of a fleet, the type of a transporter is its index in the table
+//the default table only has type 0 (velocity 1, infinite capacity, no delay), the former behavior of init_by_type
+class fleet_type_table
+{
+public:
+	fleet_type_table();
+	virtual ~fleet_type_table();
+
+	void clear() { types.clear(); }
+	ULL add_type(const transporter_type& t);	//returns the new type
+	ULL size() const { return(types.size()); }
+	const transporter_type& get_type(ULL type) const { assert(type < types.size()); return(types[type]); }
+
+	//one type per line: name velocity capacity allowed_pickup_delay allowed_dropoff_delay (empty lines and lines starting with # are skipped)
+	bool load(std::istream& in);
+	bool load(std::string filename);
+	void print(std::ofstream& out);
+
+protected:
+
+private:
+	std::vector< transporter_type > types;
+};
+
+#endif // FLEET_TYPE_TABLE_H
@@ -0,0 +1,496 @@
+#include "kinetic_tree.h"
+
+kinetic_tree::kinetic_tree()
+{
+	max_orderings = 64;
+	location = 0;
+	time = 0;
+	velocity = 1;
+	occupancy = 0;
+	capacity = -1;
+	reset(0);
+}
+
+kinetic_tree::~kinetic_tree()
+{
+	//dtor
+}
+
+//only the current schedule (stops 0, 1, ..., number of stops - 1) is known
+void kinetic_tree::reset(ULL param_number_of_stops)
+{
+	number_of_stops = param_number_of_stops;
+	number_of_orderings = 1;
+	orderings.resize(number_of_stops);
+	for (ULL k = 0; k < number_of_stops; ++k)
+		orderings[k] = k;
+
+	pending_insertion = false;
+	structure_changed = true;
+}
+
+//stops of an ordering (positions in the current schedule)
+void kinetic_tree::get_ordering(ULL ordering, std::vector<ULL>& stops)
+{
+	assert(!pending_insertion && ordering < number_of_orderings);
+	stops.assign(orderings.begin() + ordering * number_of_stops, orderings.begin() + (ordering + 1) * number_of_stops);
+}
+
+//the transporter now follows the given ordering with the pickup and dropoff of a new request inserted
+//renumber the stops by their position in the new schedule, the orderings are extended by the new stops in the next update
+void kinetic_tree::insert_request(ULL ordering, ULL pickup_insertion, ULL dropoff_insertion)
+{
+	assert(!pending_insertion && ordering < number_of_orderings && pickup_insertion <= dropoff_insertion && dropoff_insertion <= number_of_stops);
+
+	new_positions.resize(number_of_stops);
+	ULL position = 0;
+	for (ULL k = 0; k <= number_of_stops; ++k)
+	{
+		if (k == pickup_insertion)
+			pending_pickup = position++;
+		if (k == dropoff_insertion)
+			pending_dropoff = position++;
+		if (k < number_of_stops)
+			new_positions[orderings[ordering * number_of_stops + k]] = position++;
+	}
+
+	for (ULL& s : orderings)
+		s = new_positions[s];
+
+	pending_insertion = true;
+	pending_ordering = ordering;
+	pending_pickup_insertion = pickup_insertion;
+	pending_dropoff_insertion = dropoff_insertion;
+}
+
+//the transporter arrived at the first stop of the current schedule, keep the orderings starting with it
+void kinetic_tree::complete_first_stop()
+{
+	assert(!pending_insertion && number_of_stops > 0);
+
+	ULL kept_orderings = 0;
+	for (ULL i = 0; i < number_of_orderings; ++i)
+	{
+		if (orderings[i * number_of_stops] != 0)
+			continue;
+
+		for (ULL k = 1; k < number_of_stops; ++k)
+			orderings[kept_orderings * (number_of_stops - 1) + k - 1] = orderings[i * number_of_stops + k] - 1;
+		++kept_orderings;
+	}
+
+	//the current schedule starts with the stop
+	assert(kept_orderings > 0);
+
+	--number_of_stops;
+	number_of_orderings = kept_orderings;
+	orderings.resize(number_of_orderings * number_of_stops);
+	structure_changed = true;
+}
+
+//new schedule data (after the transporter moved or the schedule changed), extend the orderings by a new request, recompute the arrival times
+//and remove orderings that are no longer feasible
+void kinetic_tree::update(const std::vector<uint32_t>& param_stop_nodes, const std::vector<LL>& param_occupancy_changes, const std::vector<double>& param_deadlines,
+	ULL param_location, double param_time, double param_velocity, LL param_occupancy, LL param_capacity, traffic_network& n)
+{
+	stop_nodes = param_stop_nodes;
+	occupancy_changes = param_occupancy_changes;
+	deadlines = param_deadlines;
+	location = param_location;
+	time = param_time;
+	velocity = param_velocity;
+	occupancy = param_occupancy;
+	capacity = param_capacity;
+
+	if (pending_insertion)
+		expand_orderings(n);
+
+	assert(stop_nodes.size() == number_of_stops);
+
+	if (structure_changed)
+		build_tree();
+	while (!compute_times(n))
+		build_tree();
+}
+
+//extend every ordering by all feasible positions of the pickup and dropoff of the new request
+//(same checks as in transporter::best_offer: each stop after the pickup is delayed by the detour of the pickup, each stop after the dropoff also by the detour of the dropoff)
+void kinetic_tree::expand_orderings(traffic_network& n)
+{
+	ULL m = number_of_stops;	//stops without the new request
+	ULL pickup_node = stop_nodes[pending_pickup];
+	ULL dropoff_node = stop_nodes[pending_dropoff];
+	double direct_time = n.get_network_distance(pickup_node, dropoff_node) / velocity;
+
+	arrival_times.resize(m);
+	slacks.resize(m);
+	suffix_slacks.resize(m + 1);
+	occupancy_before.resize(m + 1);
+
+	//the current schedule is always kept (it was checked by best_insertion), it is sorted before all others
+	candidates.clear();
+	candidates.push_back({ pending_ordering, pending_pickup_insertion, pending_dropoff_insertion, -std::numeric_limits<double>::infinity() });
+
+	for (ULL i = 0; i < number_of_orderings; ++i)
+	{
+		const ULL* ordering = orderings.data() + i * m;
+
+		auto add_candidate = [&](ULL pickup_insertion, ULL dropoff_insertion, double end_time)
+		{
+			if (i != pending_ordering || pickup_insertion != pending_pickup_insertion || dropoff_insertion != pending_dropoff_insertion)
+				candidates.push_back({ i, pickup_insertion, dropoff_insertion, end_time });
+		};
+
+		//arrival times, slack and occupancy along the ordering
+		double temp_time = time;
+		ULL temp_location = location;
+		LL temp_occupancy = occupancy;
+		for (ULL k = 0; k < m; ++k)
+		{
+			temp_time += n.get_network_distance(temp_location, stop_nodes[ordering[k]]) / velocity;
+			temp_location = stop_nodes[ordering[k]];
+
+			arrival_times[k] = temp_time;
+			slacks[k] = deadlines[ordering[k]] - temp_time;
+			occupancy_before[k] = temp_occupancy;
+			temp_occupancy += occupancy_changes[ordering[k]];
+		}
+		occupancy_before[m] = temp_occupancy;
+		suffix_slacks[m] = std::numeric_limits<double>::infinity();
+		for (ULL k = m; k-- > 0; )
+			suffix_slacks[k] = std::min(slacks[k], suffix_slacks[k + 1]);
+		double end_time = (m > 0 ? arrival_times[m - 1] : time);
+
+		//pickup before the k-th stop
+		ULL previous_location = location;
+		double previous_time = time;
+		for (ULL k = 0; k <= m; ++k)
+		{
+			if (k > 0)
+			{
+				previous_location = stop_nodes[ordering[k - 1]];
+				previous_time = arrival_times[k - 1];
+			}
+
+			if (capacity >= 0 && occupancy_before[k] + 1 > capacity)
+				continue;
+
+			double pickup_time = previous_time + n.get_network_distance(previous_location, pickup_node) / velocity;
+			if (pickup_time > deadlines[pending_pickup])
+				continue;
+
+			//pick up and drop off at the end
+			if (k == m)
+			{
+				if (pickup_time + direct_time <= deadlines[pending_dropoff])
+					add_candidate(k, k, pickup_time + direct_time);
+				continue;
+			}
+
+			ULL next_location = stop_nodes[ordering[k]];
+			double pickup_delay = std::max(0.0, n.get_network_distance(previous_location, pickup_node) / velocity + n.get_network_distance(pickup_node, next_location) / velocity - n.get_network_distance(previous_location, next_location) / velocity);
+
+			//drop off right after the pickup
+			double dropoff_delay = std::max(0.0, n.get_network_distance(previous_location, pickup_node) / velocity + direct_time + n.get_network_distance(dropoff_node, next_location) / velocity - n.get_network_distance(previous_location, next_location) / velocity);
+			if (pickup_time + direct_time <= deadlines[pending_dropoff] && dropoff_delay <= suffix_slacks[k])
+				add_candidate(k, k, end_time + dropoff_delay);
+
+			//drop off before a later stop, the customer is carried through the stops in between
+			for (ULL later_position = k + 1; later_position <= m; ++later_position)
+			{
+				if (pickup_delay > slacks[later_position - 1] || (capacity >= 0 && occupancy_before[later_position] + 1 > capacity))
+					break;
+
+				ULL stop_location = stop_nodes[ordering[later_position - 1]];
+				double dropoff_time = arrival_times[later_position - 1] + pickup_delay + n.get_network_distance(stop_location, dropoff_node) / velocity;
+				if (dropoff_time > deadlines[pending_dropoff])
+					continue;
+
+				if (later_position == m)
+					add_candidate(k, later_position, dropoff_time);
+				else {
+					ULL later_location = stop_nodes[ordering[later_position]];
+					dropoff_delay = std::max(0.0, n.get_network_distance(stop_location, dropoff_node) / velocity + n.get_network_distance(dropoff_node, later_location) / velocity - n.get_network_distance(stop_location, later_location) / velocity);
+					if (pickup_delay + dropoff_delay <= suffix_slacks[later_position])
+						add_candidate(k, later_position, end_time + pickup_delay + dropoff_delay);
+				}
+			}
+		}
+	}
+
+	//keep the orderings that reach their last stop first
+	if (candidates.size() > max_orderings)
+	{
+		if (max_orderings > 1)
+			std::nth_element(candidates.begin() + 1, candidates.begin() + (max_orderings - 1), candidates.end(), [](const ordering_candidate& a, const ordering_candidate& b) { return(a.end_time < b.end_time); });
+		candidates.resize(max_orderings);
+	}
+
+	//write the extended orderings
+	number_of_stops = m + 2;
+	number_of_orderings = candidates.size();
+	new_orderings.clear();
+	for (ordering_candidate& c : candidates)
+	{
+		const ULL* ordering = orderings.data() + c.ordering * m;
+		for (ULL k = 0; k <= m; ++k)
+		{
+			if (k == c.pickup_insertion)
+				new_orderings.push_back(pending_pickup);
+			if (k == c.dropoff_insertion)
+				new_orderings.push_back(pending_dropoff);
+			if (k < m)
+				new_orderings.push_back(ordering[k]);
+		}
+	}
+	orderings.swap(new_orderings);
+
+	pending_insertion = false;
+	structure_changed = true;
+}
+
+//sort the orderings and store them as a tree (orderings with the same first stops share their nodes)
+void kinetic_tree::build_tree()
+{
+	//sort (the current schedule 0, 1, 2, ... is the smallest, so it stays ordering 0)
+	sorted_orderings.resize(number_of_orderings);
+	for (ULL i = 0; i < number_of_orderings; ++i)
+		sorted_orderings[i] = i;
+	std::sort(sorted_orderings.begin(), sorted_orderings.end(), [this](ULL a, ULL b)
+	{
+		return(std::lexicographical_compare(orderings.begin() + a * number_of_stops, orderings.begin() + (a + 1) * number_of_stops, orderings.begin() + b * number_of_stops, orderings.begin() + (b + 1) * number_of_stops));
+	});
+	new_orderings.resize(orderings.size());
+	for (ULL i = 0; i < number_of_orderings; ++i)
+		std::copy(orderings.begin() + sorted_orderings[i] * number_of_stops, orderings.begin() + (sorted_orderings[i] + 1) * number_of_stops, new_orderings.begin() + i * number_of_stops);
+	orderings.swap(new_orderings);
+
+	//each ordering adds nodes from the first stop in which it differs from the previous one
+	tree_node root;
+	root.stop = std::numeric_limits<ULL>::max();
+	root.parent = 0;
+	root.subtree_end = 1;
+	root.depth = 0;
+	root.ordering = 0;
+	tree.assign(1, root);
+
+	path.resize(number_of_stops + 1);
+	path[0] = 0;
+	for (ULL i = 0; i < number_of_orderings; ++i)
+	{
+		ULL common_stops = 0;
+		if (i > 0)
+		{
+			while (common_stops < number_of_stops && orderings[(i - 1) * number_of_stops + common_stops] == orderings[i * number_of_stops + common_stops])
+				++common_stops;
+			assert(common_stops < number_of_stops);	//no ordering twice
+		}
+
+		for (ULL k = common_stops; k < number_of_stops; ++k)
+		{
+			tree_node node = root;
+			node.stop = orderings[i * number_of_stops + k];
+			node.parent = path[k];
+			node.subtree_end = tree.size() + 1;
+			node.depth = k + 1;
+			tree.push_back(node);
+			path[k + 1] = tree.size() - 1;
+		}
+		tree[path[number_of_stops]].ordering = i;
+	}
+
+	//children are stored after their parent
+	for (ULL v = tree.size(); v-- > 1; )
+		tree[tree[v].parent].subtree_end = std::max(tree[tree[v].parent].subtree_end, tree[v].subtree_end);
+
+	structure_changed = false;
+}
+
+//arrival times and slack along the tree (from the current position of the transporter), best slack from the leaves back to the root
+bool kinetic_tree::compute_times(traffic_network& n)
+{
+	tree[0].arrival_time = time;
+	tree[0].occupancy_after = occupancy;
+	tree[0].slack = std::numeric_limits<double>::infinity();
+
+	path_min_slack.resize(tree.size());
+	path_min_slack[0] = std::numeric_limits<double>::infinity();
+	for (ULL v = 1; v < tree.size(); ++v)
+	{
+		tree_node& node = tree[v];
+		tree_node& parent = tree[node.parent];
+
+		node.arrival_time = parent.arrival_time + n.get_network_distance(location_of(node.parent), stop_nodes[node.stop]) / velocity;
+		node.occupancy_after = parent.occupancy_after + occupancy_changes[node.stop];
+		node.slack = deadlines[node.stop] - node.arrival_time;
+		path_min_slack[v] = std::min(path_min_slack[node.parent], node.slack);
+	}
+
+	for (ULL v = tree.size(); v-- > 0; )
+	{
+		tree_node& node = tree[v];
+		if (is_leaf(v))
+		{
+			node.best_slack = node.slack;
+			node.best_ordering = node.ordering;
+		}
+		else
+			node.best_slack = std::min(node.slack, node.best_slack);
+
+		//earlier children win ties (closer to the current schedule)
+		if (v > 0)
+		{
+			tree_node& parent = tree[node.parent];
+			if (node.subtree_end == parent.subtree_end || node.best_slack >= parent.best_slack)
+			{
+				parent.best_slack = node.best_slack;
+				parent.best_ordering = node.best_ordering;
+			}
+		}
+	}
+
+	//remove orderings with a stop after its deadline (the current schedule always arrives in time)
+	keep_ordering.assign(number_of_orderings, true);
+	bool removed = false;
+	for (ULL v = 0; v < tree.size(); ++v)
+	{
+		if (is_leaf(v) && tree[v].ordering > 0 && path_min_slack[v] < 0)
+		{
+			keep_ordering[tree[v].ordering] = false;
+			removed = true;
+		}
+	}
+	if (!removed)
+		return(true);
+
+	ULL kept_orderings = 0;
+	for (ULL i = 0; i < number_of_orderings; ++i)
+	{
+		if (!keep_ordering[i])
+			continue;
+		if (kept_orderings != i)
+			std::copy(orderings.begin() + i * number_of_stops, orderings.begin() + (i + 1) * number_of_stops, orderings.begin() + kept_orderings * number_of_stops);
+		++kept_orderings;
+	}
+	number_of_orderings = kept_orderings;
+	orderings.resize(number_of_orderings * number_of_stops);
+	return(false);
+}
+
+//walk the tree: pickup between a node and each of its children, then carry the customer down the subtree until the dropoff
+//an insertion is feasible if every later stop of some ordering continuing from there stays within its slack (best slack of the node)
+//the arrival times only increase along an ordering, so subtrees where the dropoff cannot be before the limit are skipped
+template<class objective>
+bool kinetic_tree::best_insertion(ULL origin, ULL destination, double request_time, double dropoff_time_limit, ULL max_pickup_positions, traffic_network& n, kinetic_insertion& best)
+{
+	typedef objective_comparison<objective> compare;
+
+	assert(!pending_insertion && !structure_changed);
+
+	bool found = false;
+	double direct_time = n.get_network_distance(origin, destination) / velocity;
+
+	//remember an insertion if it is at least as good as the best one so far
+	auto consider_insertion = [&](ULL ordering, ULL pickup_insertion, ULL dropoff_insertion, double pickup_time, double dropoff_time, double added_vehicle_time)
+	{
+		if (!found || !compare::is_better(request_time, best.pickup_time, best.dropoff_time, best.added_vehicle_time, pickup_time, dropoff_time, added_vehicle_time))
+		{
+			found = true;
+			best = { ordering, pickup_insertion, dropoff_insertion, pickup_time, dropoff_time, added_vehicle_time };
+		}
+	};
+
+	//reused buffer, best_insertion may be called for different transporters from different threads
+	static thread_local std::vector<ULL> carried_through;
+
+	ULL v = 0;
+	while (v < tree.size())
+	{
+		tree_node& node = tree[v];
+		ULL node_location = location_of(v);
+		double pickup_time = node.arrival_time + n.get_network_distance(node_location, origin) / velocity;
+
+		//no pickup in this subtree can lead to an earlier dropoff
+		if (pickup_time + direct_time > dropoff_time_limit + MACRO_EPSILON)
+		{
+			v = node.subtree_end;
+			continue;
+		}
+
+		if (capacity >= 0 && node.occupancy_after + 1 > capacity)
+		{
+			++v;
+			continue;
+		}
+
+		//pick up and drop off at the end of the ordering
+		if (is_leaf(v))
+		{
+			consider_insertion(node.ordering, number_of_stops, number_of_stops, pickup_time, pickup_time + direct_time, n.get_network_distance(node_location, origin) / velocity + direct_time);
+			++v;
+			continue;
+		}
+
+		//pickup before each child (if within the first stops)
+		for (ULL w = (node.depth < max_pickup_positions ? v + 1 : node.subtree_end); w < node.subtree_end; w = tree[w].subtree_end)
+		{
+			tree_node& next = tree[w];
+			ULL next_location = stop_nodes[next.stop];
+			ULL pickup_insertion = next.depth - 1;
+
+			double pickup_delay = std::max(0.0, n.get_network_distance(node_location, origin) / velocity + n.get_network_distance(origin, next_location) / velocity - n.get_network_distance(node_location, next_location) / velocity);
+			if (pickup_delay > next.best_slack)
+				continue;
+
+			//drop off right after the pickup
+			double dropoff_delay = std::max(0.0, n.get_network_distance(node_location, origin) / velocity + direct_time + n.get_network_distance(destination, next_location) / velocity - n.get_network_distance(node_location, next_location) / velocity);
+			if (dropoff_delay <= next.best_slack)
+				consider_insertion(next.best_ordering, pickup_insertion, pickup_insertion, pickup_time, pickup_time + direct_time, dropoff_delay);
+
+			//drop off after later stops
+			carried_through.clear();
+			if (pickup_delay <= next.slack && (capacity < 0 || next.occupancy_after + 1 <= capacity))
+				carried_through.push_back(w);
+			while (!carried_through.empty())
+			{
+				ULL x = carried_through.back();
+				carried_through.pop_back();
+
+				tree_node& passed = tree[x];
+				ULL passed_location = stop_nodes[passed.stop];
+				double dropoff_time = passed.arrival_time + pickup_delay + n.get_network_distance(passed_location, destination) / velocity;
+				if (dropoff_time > dropoff_time_limit + MACRO_EPSILON)
+					continue;
+
+				if (is_leaf(x))
+				{
+					consider_insertion(passed.ordering, pickup_insertion, number_of_stops, pickup_time, dropoff_time, pickup_delay + n.get_network_distance(passed_location, destination) / velocity);
+					continue;
+				}
+
+				for (ULL y = x + 1; y < passed.subtree_end; y = tree[y].subtree_end)
+				{
+					tree_node& later = tree[y];
+					ULL later_location = stop_nodes[later.stop];
+
+					dropoff_delay = std::max(0.0, n.get_network_distance(passed_location, destination) / velocity + n.get_network_distance(destination, later_location) / velocity - n.get_network_distance(passed_location, later_location) / velocity);
+					if (pickup_delay + dropoff_delay <= later.best_slack)
+						consider_insertion(later.best_ordering, pickup_insertion, later.depth - 1, pickup_time, dropoff_time, pickup_delay + dropoff_delay);
+
+					if (pickup_delay <= later.slack && (capacity < 0 || later.occupancy_after + 1 <= capacity))
+						carried_through.push_back(y);
+				}
+			}
+		}
+
+		++v;
+	}
+
+	return(found);
+}
+
+//instantiate the tree walk for all objectives (see dispatch_objective.h)
+template bool kinetic_tree::best_insertion<earliest_dropoff_objective>(ULL origin, ULL destination, double request_time, double dropoff_time_limit, ULL max_pickup_positions, traffic_network& n, kinetic_insertion& best);
+template bool kinetic_tree::best_insertion<minimal_wait_objective>(ULL origin, ULL destination, double request_time, double dropoff_time_limit, ULL max_pickup_positions, traffic_network& n, kinetic_insertion& best);
+template bool kinetic_tree::best_insertion<minimal_added_vehicle_time_objective>(ULL origin, ULL destination, double request_time, double dropoff_time_limit, ULL max_pickup_positions, traffic_network& n, kinetic_insertion& best);
+template bool kinetic_tree::best_insertion<default_weighted_cost_objective>(ULL origin, ULL destination, double request_time, double dropoff_time_limit, ULL max_pickup_positions, traffic_network& n, kinetic_insertion& best);
@@ -0,0 +1,143 @@
+#ifndef KINETIC_TREE_H
+#define KINETIC_TREE_H
+
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include <cassert>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+#ifndef _EPSILON
+#define MACRO_EPSILON 0.000000000001
+#define _EPSILON
+#endif
+
+#include "traffic_network.h"
+#include "dispatch_objective.h"
+
+//insertion of a request into one ordering of a kinetic tree (positions as in offer, but referring to the stops in that ordering)
+struct kinetic_insertion
+{
+	ULL ordering;
+	ULL pickup_insertion;
+	ULL dropoff_insertion;
+	double pickup_time;
+	double dropoff_time;
+	double added_vehicle_time;
+};
+
+//all feasible orderings of the assigned stops of a transporter, stored as a tree (each path from the root to a leaf is one ordering)
+//an ordering is feasible if it respects the capacity and no stop arrives after its deadline (latest arrival allowed by the delay of its customer)
+//
+//stops are identified by their position in the current schedule of the transporter, so the current schedule is always ordering 0 (0, 1, 2, ...)
+//the tree is kept up to date incrementally:
+//	insertion of a request: every ordering is extended by every feasible position of the new pickup and dropoff
+//	stop completed: only the orderings starting with that stop are kept
+//	transporter moved: arrival times are recomputed and orderings that are no longer feasible are removed
+//the number of orderings is limited, if there are more, those that reach their last stop first are kept
+class kinetic_tree
+{
+public:
+	kinetic_tree();
+	virtual ~kinetic_tree();
+
+	void reset(ULL param_number_of_stops);	//only the current schedule
+	void set_max_orderings(ULL param_max_orderings) { max_orderings = std::max((ULL)1, param_max_orderings); }
+
+	ULL get_number_of_stops() { return(number_of_stops); }
+	ULL get_number_of_orderings() { return(number_of_orderings); }
+	void get_ordering(ULL ordering, std::vector<ULL>& stops);
+
+	void insert_request(ULL ordering, ULL pickup_insertion, ULL dropoff_insertion);	//this ordering with the new stops becomes the current schedule
+	void complete_first_stop();
+
+	//schedule data per stop (in the order of the current schedule, including new stops) and the state of the transporter
+	void update(const std::vector<uint32_t>& param_stop_nodes, const std::vector<LL>& param_occupancy_changes, const std::vector<double>& param_deadlines,
+		ULL param_location, double param_time, double param_velocity, LL param_occupancy, LL param_capacity, traffic_network& n);
+
+	//best insertion of a request into any of the orderings (false if none), insertions with a later dropoff than the limit are skipped
+	//pickups only before the first stops of an ordering (and at its end)
+	template<class objective = earliest_dropoff_objective>
+	bool best_insertion(ULL origin, ULL destination, double request_time, double dropoff_time_limit, ULL max_pickup_positions, traffic_network& n, kinetic_insertion& best);
+
+protected:
+
+private:
+	struct tree_node
+	{
+		ULL stop;				//stop of this node (the root has none)
+		ULL parent;
+		ULL subtree_end;		//nodes are stored in depth first order, the subtree of a node ends before this index
+		ULL depth;				//position of the stop in the ordering + 1 (root: 0)
+		ULL ordering;			//leaves: index of the ordering
+
+		double arrival_time;
+		LL occupancy_after;		//occupancy after the stop
+		double slack;			//deadline - arrival time
+		double best_slack;		//largest minimal slack over this and all later stops of any ordering continuing this node
+		ULL best_ordering;		//ordering with the best slack
+	};
+
+	void expand_orderings(traffic_network& n);
+	void build_tree();
+	bool compute_times(traffic_network& n);	//false if infeasible orderings were removed (tree has to be rebuilt)
+
+	ULL location_of(ULL node) { return(node == 0 ? location : (ULL)stop_nodes[tree[node].stop]); }
+	bool is_leaf(ULL node) { return(tree[node].depth == number_of_stops); }
+
+	ULL max_orderings;
+
+	//orderings of the stops, number_of_stops entries each, sorted (the current schedule is the first)
+	ULL number_of_stops;
+	ULL number_of_orderings;
+	std::vector<ULL> orderings;
+	std::vector<tree_node> tree;
+	bool structure_changed;
+
+	//request inserted, orderings not yet extended by the new stops (done by update, which knows their deadlines)
+	bool pending_insertion;
+	ULL pending_ordering;
+	ULL pending_pickup_insertion;
+	ULL pending_dropoff_insertion;
+	ULL pending_pickup;
+	ULL pending_dropoff;
+
+	//data of the stops and the transporter at the last update
+	std::vector<uint32_t> stop_nodes;
+	std::vector<LL> occupancy_changes;
+	std::vector<double> deadlines;
+	ULL location;
+	double time;
+	double velocity;
+	LL occupancy;
+	LL capacity;
+
+	//reused buffers
+	struct ordering_candidate
+	{
+		ULL ordering;
+		ULL pickup_insertion;
+		ULL dropoff_insertion;
+		double end_time;
+	};
+	std::vector<ordering_candidate> candidates;
+	std::vector<ULL> new_orderings;
+	std::vector<ULL> new_positions;
+	std::vector<ULL> sorted_orderings;
+	std::vector<ULL> path;
+	std::vector<double> path_min_slack;
+	std::vector<bool> keep_ordering;
+	std::vector<double> arrival_times;
+	std::vector<double> slacks;
+	std::vector<double> suffix_slacks;
+	std::vector<LL> occupancy_before;
+};
+
+#endif // KINETIC_TREE_H
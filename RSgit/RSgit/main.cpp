@@ -49,6 +49,10 @@ int main(int argc, char* argv[])
 	ULL number_of_buses = 100;
 	ULL number_of_nodes = 25;
 	double normalized_request_rate = 7.5;
+	bool dispatcher_benchmark = false;		//compare several dispatchers on the same requests instead of the measurement run
+	bool dispatch_check = false;			//transporters allow delays and every offer is compared with checking all transporters (see ridesharing_sim::enable_dispatch_check)
+	ULL dispatch_check_threads = 4;		//threads of the search during the dispatch check (1: sequential search)
+	ULL dispatch_check_window = 8;		//upcoming requests with offers found in advance during the dispatch check (0: no speculative dispatch)
 
 	std::stringstream filename("");
 	filename << topology << "_N_" << number_of_nodes << "__B_" << number_of_buses << "__x_" << normalized_request_rate << ".dat";
@@ -198,6 +202,20 @@ int main(int argc, char* argv[])
 	}
 
 
+	//check of the search: the bounds must also hold for offers that delay the stops of other customers (type 0 with allowed delays, before any transporter has stops)
+	//with several threads, the offers must also not depend on which thread finds a good offer first, and offers found in advance must still be the best when they are taken
+	if (dispatch_check)
+	{
+		fleet_type_table delay_types;
+		delay_types.clear();
+		delay_types.add_type(transporter_type("delay", 1, -1, 1.0, 1.3));
+		sim.set_fleet_types(delay_types);
+		sim.enable_dispatch_check();
+		sim.set_number_of_dispatch_threads(dispatch_check_threads);
+		if (dispatch_check_window > 0)
+			sim.enable_speculative_dispatch(dispatch_check_window);
+	}
+
 	//simulate the requests to realize equal distribution of buses
 	sim.run_sim_request_list(request_list);
 
@@ -206,6 +224,24 @@ int main(int argc, char* argv[])
 	//equilibrate simulation for 10 requests per bus (at least 1000 requests) to obtain a "correct" initial condition
 	//this may not be long enough if the initial request list was too long or the network is large, some try-and-error may be needed here
 	sim.run_sim_requests(std::max((ULL)1000, 10 * number_of_buses));
+
+	//benchmark: replay the same requests (100 per bus) with each dispatcher, starting from the equilibrated state
+	if (dispatcher_benchmark)
+	{
+		insertion_dispatcher earliest_dropoff_dispatcher(earliest_dropoff);
+		insertion_dispatcher minimal_wait_dispatcher(minimal_wait);
+		insertion_dispatcher minimal_added_vehicle_time_dispatcher(minimal_added_vehicle_time);
+		insertion_dispatcher weighted_cost_dispatcher(weighted_cost);
+		std::vector<dispatcher*> dispatchers = { &earliest_dropoff_dispatcher, &minimal_wait_dispatcher, &minimal_added_vehicle_time_dispatcher, &weighted_cost_dispatcher };
+
+		std::vector<dispatcher_benchmark_result> results = sim.run_dispatcher_benchmark(sim.generate_request_list(std::max((ULL)10000, 100 * number_of_buses)), dispatchers, (1.0 * number_of_buses) / sim.request_rate);
+		sim.print_params(out, true);
+		sim.print_dispatcher_benchmark(results, out);
+
+		out.close();
+		return(0);
+	}
+
 	//turn on measurements with a given step size, measure every (number of buses) requests for a total of ~ 100 measurements
 	sim.enable_measurements((1.0 * number_of_buses) / sim.request_rate);
 	//simulate (and measure) for 100 requests per bus (at least 10000 requests)
@@ -217,6 +253,13 @@ int main(int argc, char* argv[])
 
 	out.close();
 
+	//every offer of the search must be the offer of the full scan
+	if (dispatch_check)
+	{
+		std::cout << "dispatch check: " << sim.different_checked_offers << " of " << sim.checked_requests << " offers differ from the full scan" << std::endl;
+		assert(sim.different_checked_offers == 0);
+	}
+
 	return(0);
 }
 
@@ -28,6 +28,16 @@ void measurement_collector::measure_trip(std::pair<ULL, double> last_stop, std::
 	new_measurement(drive_time_between_stops, current_stop.second - last_stop.second);
 }
 
+//decision of the admission control for a request
+void measurement_collector::measure_admission(admission_decision decision)
+{
+	new_measurement(fraction_of_rejected_requests, decision != admitted ? 1 : 0);
+	new_measurement(fraction_rejected_full_schedules, decision == rejected_full_schedules ? 1 : 0);
+	new_measurement(fraction_rejected_no_offer, decision == rejected_no_offer ? 1 : 0);
+	new_measurement(fraction_rejected_wait, decision == rejected_wait ? 1 : 0);
+	new_measurement(fraction_rejected_detour, decision == rejected_detour ? 1 : 0);
+}
+
 //void measurement_collector::measure_stops(...)
 //{
 //	new_measurement(drive_time_between_stops, c.get_pickup_time() - c.get_request_time());
@@ -65,6 +75,11 @@ void measurement_collector::reset()
 	planned_time_horizon.reset();
 	number_of_idle_transporters.reset();
 
+	fraction_of_rejected_requests.reset();
+	fraction_rejected_full_schedules.reset();
+	fraction_rejected_no_offer.reset();
+	fraction_rejected_wait.reset();
+	fraction_rejected_detour.reset();
 }
 
 void measurement_collector::print(std::ofstream& out, bool readable)
@@ -85,6 +100,15 @@ void measurement_collector::print(std::ofstream& out, bool readable)
 		planned_time_horizon.print(out);
 		number_of_idle_transporters.print(out);
 
+		if (fraction_of_rejected_requests.n > 0)
+		{
+			fraction_of_rejected_requests.print(out);
+			fraction_rejected_full_schedules.print(out);
+			fraction_rejected_no_offer.print(out);
+			fraction_rejected_wait.print(out);
+			fraction_rejected_detour.print(out);
+		}
+
 		out << std::endl;
 	}
 	else
@@ -135,6 +159,29 @@ void measurement_collector::print(std::ofstream& out, bool readable)
 		number_of_idle_transporters.print(out);
 		out << std::endl;
 
+		if (fraction_of_rejected_requests.n > 0)
+		{
+			out << "fraction_of_rejected_requests: " << std::endl;
+			fraction_of_rejected_requests.print(out);
+			out << std::endl;
+
+			out << "fraction_rejected_full_schedules: " << std::endl;
+			fraction_rejected_full_schedules.print(out);
+			out << std::endl;
+
+			out << "fraction_rejected_no_offer: " << std::endl;
+			fraction_rejected_no_offer.print(out);
+			out << std::endl;
+
+			out << "fraction_rejected_wait: " << std::endl;
+			fraction_rejected_wait.print(out);
+			out << std::endl;
+
+			out << "fraction_rejected_detour: " << std::endl;
+			fraction_rejected_detour.print(out);
+			out << std::endl;
+		}
+
 		out << std::endl;
 	}
 }
@@ -20,6 +20,7 @@
 #include "customer.h"
 #include "transporter.h"
 #include "traffic_network.h"
+#include "admission_policy.h"
 
 class customer;
 class transporter;
@@ -42,9 +43,16 @@ public:
 	void measure_request(customer& c, transporter& t);
 	void measure_trip(std::pair<ULL, double> last_stop, std::pair<ULL, double> current_stop);
 	void measure_system_status(std::vector<transporter>& transporter_list, double time);
+	void measure_admission(admission_decision decision);
 	void reset();
 	void print(std::ofstream& out, bool readable = false);
 
+	measure get_wait_time() { return(wait_time); }
+	measure get_drive_time() { return(drive_time); }
+	measure get_delay_time() { return(delay_time); }
+	measure get_fraction_of_delayed_trips() { return(fraction_of_delayed_trips); }
+	measure get_fraction_of_rejected_requests() { return(fraction_of_rejected_requests); }
+
 protected:
 
 private:
@@ -63,6 +71,13 @@ private:
 	measure planned_time_horizon;
 	measure number_of_idle_transporters;
 
+	//admission control (only measured and printed if enabled), fractions of all requests
+	measure fraction_of_rejected_requests;
+	measure fraction_rejected_full_schedules;
+	measure fraction_rejected_no_offer;
+	measure fraction_rejected_wait;
+	measure fraction_rejected_detour;
+
 	traffic_network& network;
 
 	void new_measurement(measure& m, long double val);
@@ -6,6 +6,7 @@ ridesharing_sim::ridesharing_sim(ULL param_N, ULL param_B, ULL seed) : network(p
 {
 	//see random generator
 	random_generator.seed(seed);
+	request_random_generator.seed(seed + 1);	//another stream than the choice between equally short routes
 
 	//setup list of transporters
 	transporter_list = std::vector<transporter>(param_B, transporter(-1, 0, 0, random_generator));
@@ -27,9 +28,53 @@ ridesharing_sim::ridesharing_sim(ULL param_N, ULL param_B, ULL seed) : network(p
 	disable_measurements();
 	disable_timeseries_output();
 
+	//default: insertion dispatcher, minimize the dropoff time
+	set_dispatcher(NULL);
+	set_dispatch_objective(earliest_dropoff);
+	disable_kinetic_trees();
+	set_fleet_types(fleet_type_table());
+	disable_approximate_dispatch();
+	shadow_fraction = 0;
+	reset_shadow_statistics();
+	speculation_window = 1;
+	speculation_round = 0;
+	next_upcoming_request = 0;
+	disable_speculative_dispatch();
+	speculative_hits = 0;
+	speculative_misses = 0;
+	schedule_optimization_time_step = 0;
+	next_schedule_optimization_time = 0;
+	schedule_optimization_max_passes = 1;
+	number_of_schedule_snapshots = 0;
+	disable_schedule_optimization();
+	reordered_schedules = 0;
+	total_schedule_time_saved = 0;
+	reassignment_time_step = 0;
+	next_reassignment_time = 0;
+	number_of_reassignment_moves = 0;
+	disable_reassignment();
+	reassigned_customers = 0;
+	total_reassignment_time_saved = 0;
+	transporters_with_room = 0;
+	disable_admission_control();
+	disable_dispatch_timing();
+	do_batch_dispatch = false;
+	batch_window = 0;
+	batch_candidates = 1;
+	next_batch_time = 0;
+
+	//default: search transporters ordered by their lower bound (same result as checking all transporters)
+	enable_bound_ordered_search();
+	disable_dispatch_check();
+	dispatch_buckets.resize(64);
+	enable_idle_index();
+	set_number_of_dispatch_threads(1);
+	total_best_offer_calls = 0;
+
 	start_of_measured_time = 0;
 	start_of_measured_total_requests = 0;
 	start_of_measured_serviced_requests = 0;
+	start_of_measured_best_offer_calls = 0;
 
 	start_of_output_time = 0;
 
@@ -48,6 +93,7 @@ ridesharing_sim::~ridesharing_sim()
 void ridesharing_sim::reset_measurements()
 {
 	measurements.reset();
+	dispatch_work.reset();
 	disable_measurements();
 }
 
@@ -55,6 +101,9 @@ void ridesharing_sim::reset_measurements()
 void ridesharing_sim::print_measurements(std::ofstream& out)
 {
 	measurements.print(out, true);
+#ifdef DISPATCH_INSTRUMENTATION
+	dispatch_work.print(out, true);
+#endif
 }
 
 //output parameters of the simulation
@@ -84,7 +133,67 @@ void ridesharing_sim::print_params(std::ofstream& out, bool readable)
 			"network.get_mean_dropoff_distance()" << std::endl << network.get_mean_dropoff_distance() << std::endl <<
 			"network.get_request_asymmetry()" << std::endl << network.get_request_asymmetry() << std::endl <<
 			"total_velocity" << std::endl << total_velocity << std::endl <<
-			std::endl;
+			"best_offer calls per request" << std::endl << (total_requests > start_of_measured_total_requests ? (total_best_offer_calls - start_of_measured_best_offer_calls) / (double)(total_requests - start_of_measured_total_requests) : 0) << std::endl;
+
+		//types of a mixed fleet (first transporter of each type)
+		if (!fleet_type_begin.empty())
+		{
+			out << "fleet types (name, velocity, capacity, allowed pickup delay, allowed dropoff delay, first transporter, transporters)" << std::endl;
+			for (ULL type = 0; type + 1 < fleet_type_begin.size(); ++type)
+			{
+				const transporter_type& t = fleet_types.get_type(type);
+				out << t.name << '\t' << t.velocity << '\t' << t.capacity << '\t' << t.allowed_pickup_delay << '\t' << t.allowed_dropoff_delay << '\t' << fleet_type_begin[type] << '\t' << fleet_type_begin[type + 1] - fleet_type_begin[type] << std::endl;
+			}
+		}
+
+		//approximate dispatch compared to the exact dispatch on the sampled requests
+		if (do_approximate_dispatch)
+		{
+			out << "approximate dispatch (transporters, pickup positions, shadow fraction)" << std::endl << approximate_transporters << '\t' << approximate_pickup_positions << '\t' << shadow_fraction << std::endl <<
+				"shadow evaluated requests" << std::endl << shadow_requests << std::endl <<
+				"fraction of different offers" << std::endl << (shadow_requests > 0 ? shadow_different_offers / (double)shadow_requests : 0) << std::endl <<
+				"mean cost loss (cost of the objective)" << std::endl << (shadow_compared_offers > 0 ? shadow_total_cost_loss / shadow_compared_offers : 0) << std::endl <<
+				"max cost loss (cost of the objective)" << std::endl << shadow_max_cost_loss << std::endl;
+			if (do_admission_control)
+				out << "shadow evaluated requests without approximate offer (but with exact offer)" << std::endl << shadow_missed_offers << std::endl;
+		}
+
+		//offers of the search compared with checking all transporters
+		if (do_dispatch_check)
+		{
+			out << "dispatch check (checked requests, offers different from the full scan)" << std::endl << checked_requests << '\t' << different_checked_offers << std::endl;
+		}
+
+		//requests dispatched with the offer found in advance
+		if (do_speculative_dispatch)
+		{
+			out << "speculative dispatch (window)" << std::endl << speculation_window << std::endl <<
+				"fraction of speculative offers used" << std::endl << (speculative_hits + speculative_misses > 0 ? speculative_hits / (double)(speculative_hits + speculative_misses) : 0) << std::endl;
+		}
+
+		//schedules reordered by the re-optimization
+		if (do_schedule_optimization)
+		{
+			out << "schedule optimization (time step, max passes)" << std::endl << schedule_optimization_time_step << '\t' << schedule_optimization_max_passes << std::endl <<
+				"reordered schedules per request" << std::endl << reordered_schedules / (double)(total_requests - start_of_measured_total_requests) << std::endl <<
+				"mean time saved per reordered schedule" << std::endl << (reordered_schedules > 0 ? total_schedule_time_saved / reordered_schedules : 0) << std::endl;
+		}
+
+		//customers moved to another transporter
+		if (do_reassignment)
+		{
+			out << "reassignment (time step)" << std::endl << reassignment_time_step << std::endl <<
+				"reassigned customers per request" << std::endl << reassigned_customers / (double)(total_requests - start_of_measured_total_requests) << std::endl <<
+				"mean vehicle time saved per reassigned customer" << std::endl << (reassigned_customers > 0 ? total_reassignment_time_saved / reassigned_customers : 0) << std::endl;
+		}
+
+		//limits of the admission control (rejected requests are printed with the measurements)
+		if (do_admission_control)
+		{
+			out << "admission control (max wait, max detour ratio, max planned stops)" << std::endl << admission.get_max_wait() << '\t' << admission.get_max_detour_ratio() << '\t' << admission.get_max_planned_stops() << std::endl;
+		}
+
+		out << std::endl;
 	}
 }
 
@@ -133,10 +242,19 @@ void ridesharing_sim::reset_number_of_buses(ULL param_number_of_buses)
 {
 	transporter_list.clear();
 	transporter_list = std::vector<transporter>(param_number_of_buses, transporter(-1, 0, 0, random_generator));
+	customers.clear();
+	pending_requests.clear();
+	drop_used_upcoming_requests();
+	if (kinetic_tree_orderings > 0)
+		enable_kinetic_trees(kinetic_tree_orderings);
+	set_fleet_types(fleet_types);
+	if (do_admission_control)
+		enable_admission_control(admission.get_max_wait(), admission.get_max_detour_ratio(), admission.get_max_planned_stops());
 
 	time = 0;
 	total_requests = 0;
 	total_serviced_requests = 0;
+	total_best_offer_calls = 0;
 
 	while (!transporter_event_queue.empty())
 		transporter_event_queue.pop();
@@ -150,6 +268,7 @@ void ridesharing_sim::reset_number_of_buses(ULL param_number_of_buses)
 	start_of_measured_time = 0;
 	start_of_measured_total_requests = 0;
 	start_of_measured_serviced_requests = 0;
+	start_of_measured_best_offer_calls = 0;
 
 	start_of_output_time = 0;
 
@@ -160,6 +279,7 @@ void ridesharing_sim::reset_number_of_buses(ULL param_number_of_buses)
 void ridesharing_sim::enable_measurements(double param_measurement_time_step)
 {
 	measurements.reset();
+	dispatch_work.reset();
 
 	assert(param_measurement_time_step > 0);
 	if (param_measurement_time_step <= 0)
@@ -174,6 +294,14 @@ void ridesharing_sim::enable_measurements(double param_measurement_time_step)
 		start_of_measured_time = time;
 		start_of_measured_total_requests = total_requests;
 		start_of_measured_serviced_requests = total_serviced_requests;
+		start_of_measured_best_offer_calls = total_best_offer_calls;
+		reset_shadow_statistics();
+		speculative_hits = 0;
+		speculative_misses = 0;
+		reordered_schedules = 0;
+		total_schedule_time_saved = 0;
+		reassigned_customers = 0;
+		total_reassignment_time_saved = 0;
 	}
 }
 
@@ -183,6 +311,121 @@ void ridesharing_sim::disable_measurements()
 	do_measurement = false;
 }
 
+//turn on the search over transporters ordered by lower bounds
+void ridesharing_sim::enable_bound_ordered_search()
+{
+	do_bound_ordered_search = true;
+}
+
+//turn off the search over transporters ordered by lower bounds (check every transporter)
+void ridesharing_sim::disable_bound_ordered_search()
+{
+	do_bound_ordered_search = false;
+}
+
+//turn on the comparison of every offer with the full scan (see check_offer)
+void ridesharing_sim::enable_dispatch_check()
+{
+	do_dispatch_check = true;
+	checked_requests = 0;
+	different_checked_offers = 0;
+}
+
+//turn off the comparison with the full scan
+void ridesharing_sim::disable_dispatch_check()
+{
+	do_dispatch_check = false;
+	checked_requests = 0;
+	different_checked_offers = 0;
+}
+
+//set the objective of the dispatcher (see dispatch_objective.h)
+void ridesharing_sim::set_dispatch_objective(dispatch_objective_type param_objective)
+{
+	dispatch_objective = param_objective;
+}
+
+//turn on kinetic trees with at most the given number of orderings per transporter
+void ridesharing_sim::enable_kinetic_trees(ULL param_max_orderings)
+{
+	assert(param_max_orderings > 0);
+
+	kinetic_tree_orderings = param_max_orderings;
+	for (transporter& t : transporter_list)
+		t.enable_kinetic_tree(kinetic_tree_orderings, network);
+	discard_speculative_offers();
+}
+
+//turn off kinetic trees (insert into the current schedule of each transporter)
+void ridesharing_sim::disable_kinetic_trees()
+{
+	kinetic_tree_orderings = 0;
+	for (transporter& t : transporter_list)
+		t.disable_kinetic_tree();
+	discard_speculative_offers();
+}
+
+//set the table of the transporter types, all transporters keep their type (it must be in the table)
+void ridesharing_sim::set_fleet_types(const fleet_type_table& param_fleet_types)
+{
+	if (&param_fleet_types != &fleet_types)
+		fleet_types = param_fleet_types;
+	for (transporter& t : transporter_list)
+		t.set_fleet_types(&fleet_types, t.get_type());
+	fleet_type_begin.clear();
+	discard_speculative_offers();
+}
+
+//set the number of transporters of each type of the table, the first ones get type 0, the next ones type 1 and so on
+void ridesharing_sim::set_fleet_composition(const std::vector<ULL>& param_transporters_per_type)
+{
+	assert(param_transporters_per_type.size() <= fleet_types.size());
+
+	fleet_type_begin.assign(1, 0);
+	for (ULL type = 0; type < param_transporters_per_type.size(); ++type)
+	{
+		for (ULL i = fleet_type_begin.back(); i < fleet_type_begin.back() + param_transporters_per_type[type]; ++i)
+		{
+			assert(i < transporter_list.size());
+			transporter_list[i].set_fleet_types(&fleet_types, type);
+		}
+		fleet_type_begin.push_back(fleet_type_begin.back() + param_transporters_per_type[type]);
+	}
+	assert(fleet_type_begin.back() == transporter_list.size());
+	discard_speculative_offers();
+}
+
+//dispatch requests with the given dispatcher (NULL: insertion with the objective of the simulation, see find_best_offer)
+void ridesharing_sim::set_dispatcher(dispatcher* param_dispatcher)
+{
+	request_dispatcher = param_dispatcher;
+}
+
+//turn on measuring the time needed to dispatch each request
+void ridesharing_sim::enable_dispatch_timing()
+{
+	do_dispatch_timing = true;
+	dispatch_latencies.clear();
+}
+
+//turn off measuring the time needed to dispatch each request
+void ridesharing_sim::disable_dispatch_timing()
+{
+	do_dispatch_timing = false;
+}
+
+//set the number of threads used to find the best offer (1: sequential search)
+void ridesharing_sim::set_number_of_dispatch_threads(ULL param_number_of_threads)
+{
+	assert(param_number_of_threads > 0);
+
+	dispatch_workers.set_number_of_threads(param_number_of_threads);
+	dispatch_part_best_offers.resize(param_number_of_threads);
+	dispatch_part_best_offer_calls.resize(param_number_of_threads);
+	dispatch_part_offer_heaps.resize(param_number_of_threads);
+	dispatch_part_candidates.resize(param_number_of_threads);
+}
+
 //turn on timeseries output
 void ridesharing_sim::enable_timeseries_output(double param_output_time_step, std::string output_filename)
 {
@@ -244,6 +487,13 @@ void ridesharing_sim::run_sim_requests(ULL sim_requests)
 {
 	ULL max_requests = total_requests + sim_requests;
 
+	//transporters may have been changed since the last run
+	if (do_idle_index)
+		rebuild_idle_index();
+	if (do_admission_control)
+		rebuild_admission_state();
+	rebuild_fleet_load();
+
 	while (total_requests < max_requests)
 	{
 		time = execute_next_event();
@@ -256,6 +506,13 @@ void ridesharing_sim::run_sim_time(long double sim_time)
 {
 	double max_time = time + sim_time;
 
+	//transporters may have been changed since the last run
+	if (do_idle_index)
+		rebuild_idle_index();
+	if (do_admission_control)
+		rebuild_admission_state();
+	rebuild_fleet_load();
+
 	while (time < max_time)
 	{
 		time = execute_next_event();
@@ -270,12 +527,18 @@ double ridesharing_sim::execute_next_event()
 
 	// geaend.
 
+	//with batch dispatch, collected requests are dispatched at the end of their window
+	double next_dispatch_time = next_request_time;
+	if (do_batch_dispatch && !pending_requests.empty())
+		next_dispatch_time = std::min(next_dispatch_time, next_batch_time);
 
 	//if the next event is an output event (and output is enabled)
 	if (do_timeseries_output &&
-		next_output_time < next_request_time &&
+		next_output_time < next_dispatch_time &&
 		(transporter_event_queue.empty() || next_output_time < transporter_event_queue.top().first) &&
-		(!do_measurement || next_output_time < next_measurement_time)
+		(!do_measurement || next_output_time < next_measurement_time) &&
+		(!do_schedule_optimization || next_output_time < next_schedule_optimization_time) &&
+		(!do_reassignment || next_output_time < next_reassignment_time)
 		)
 	{
 		event_time = next_output_time;
@@ -285,8 +548,10 @@ double ridesharing_sim::execute_next_event()
 	}
 	//if the next event is a measurement event (and measurement is enabled)
 	else if (do_measurement &&
-		next_measurement_time < next_request_time &&
-		(transporter_event_queue.empty() || next_measurement_time < transporter_event_queue.top().first)
+		next_measurement_time < next_dispatch_time &&
+		(transporter_event_queue.empty() || next_measurement_time < transporter_event_queue.top().first) &&
+		(!do_schedule_optimization || next_measurement_time < next_schedule_optimization_time) &&
+		(!do_reassignment || next_measurement_time < next_reassignment_time)
 		)
 	{
 		event_time = next_measurement_time;
@@ -294,47 +559,70 @@ double ridesharing_sim::execute_next_event()
 
 		next_measurement_time += measurement_time_step;
 	}
+	//if the next event is the re-optimization of the schedules (and it is enabled)
+	else if (do_schedule_optimization &&
+		next_schedule_optimization_time < next_dispatch_time &&
+		(transporter_event_queue.empty() || next_schedule_optimization_time < transporter_event_queue.top().first) &&
+		(!do_reassignment || next_schedule_optimization_time < next_reassignment_time)
+		)
+	{
+		event_time = next_schedule_optimization_time;
+		optimize_schedules();
+
+		next_schedule_optimization_time += schedule_optimization_time_step;
+	}
+	//if the next event is the reassignment of customers that are not yet picked up (and it is enabled)
+	else if (do_reassignment &&
+		next_reassignment_time < next_dispatch_time &&
+		(transporter_event_queue.empty() || next_reassignment_time < transporter_event_queue.top().first)
+		)
+	{
+		event_time = next_reassignment_time;
+		reassign_customers(event_time);
+
+		next_reassignment_time += reassignment_time_step;
+	}
+	//if the next event is the dispatch of the collected requests
+	else if (next_dispatch_time < next_request_time &&
+		(transporter_event_queue.empty() || next_dispatch_time < transporter_event_queue.top().first)
+		)
+	{
+		event_time = next_batch_time;
+		dispatch_batch(event_time);
+	}
 	//if the next event is a new_request event
 	else if (transporter_event_queue.empty() || next_request_time < transporter_event_queue.top().first)
 	{
-		offer current_offer;
-		offer current_best_offer;
-
 		ULL request_origin;
 		ULL request_destination;
 
-		ULL event_transporter_index;
-		double next_transporter_event;
-
 		event_time = next_request_time;
-		++total_requests;
-		std::tie(request_origin, request_destination) = network.generate_request();
 
-		current_best_offer = offer();
-		//find the best offer for the request
-		for (transporter& t : transporter_list)
+		//requests are drawn a window ahead, so that their offers can be found in advance
+		//requests drawn ahead are used first, in the order they were drawn (the same requests as drawing each one when it happens)
+		if (do_speculative_dispatch && next_upcoming_request >= upcoming_requests.size())
+			draw_upcoming_requests();
+		double request_interval;
+		if (next_upcoming_request < upcoming_requests.size())
 		{
-			current_offer = t.best_offer(request_origin, request_destination, event_time, network, current_best_offer);
-			if (current_offer.is_better_offer)
-			{
-				assert(current_offer.dropoff_time <= current_best_offer.dropoff_time);
-				current_best_offer = current_offer;
-			}
+			std::tie(request_origin, request_destination) = upcoming_requests[next_upcoming_request].second;
+			request_interval = upcoming_request_intervals[next_upcoming_request];
+			++next_upcoming_request;
+		}
+		else
+		{
+			std::tie(request_origin, request_destination) = network.generate_request(request_random_generator);
+			request_interval = exp_dist(request_random_generator);
 		}
 
-		//assign the request to the best transporter and update the events
-		event_transporter_index = current_best_offer.transporter_index;
-		next_transporter_event = transporter_list[event_transporter_index].assign_customer(
-			event_time,
-			customer(request_origin, request_destination, event_time, network, transporter_list[event_transporter_index], current_best_offer),
-			current_best_offer,
-			network
-		);
-		if (next_transporter_event >= event_time)
-			transporter_event_queue.push(std::make_pair(next_transporter_event, event_transporter_index));
+		//dispatch the request and assign it to the transporter of the offer (or collect it for batch dispatch)
+		if (do_batch_dispatch)
+			collect_request(request_origin, request_destination, event_time);
+		else
+			handle_request(request_origin, request_destination, event_time);
 
 		//update event queue with the next request (exponential distribution with mean 1/request rate)
-		next_request_time = event_time + exp_dist(random_generator) / request_rate;
+		next_request_time = event_time + request_interval / request_rate;
 
 	}
 	else {	//the next event is a bus event (bus arriving at a node along its route)
@@ -346,124 +634,1908 @@ double ridesharing_sim::execute_next_event()
 		transporter_event_queue.pop();
 
 		//execute event and handle the next event of the transporter (if any)
-		next_transporter_event = transporter_list[event_transporter_index].execute_event(event_time, network, measurements, total_serviced_requests, do_measurement);
+		next_transporter_event = transporter_list[event_transporter_index].execute_event(event_time, network, customers, measurements, total_serviced_requests, do_measurement);
+		mark_transporter_modified(event_transporter_index);
 
 		//update event queue with the next event of the transporter
+		update_idle_index(event_transporter_index);
+		update_admission_state(event_transporter_index);
+		update_fleet_load(event_transporter_index);
 		if (next_transporter_event >= event_time)
 			transporter_event_queue.push(std::make_pair(next_transporter_event, event_transporter_index));
 	}
 	return(event_time);
 }
 
-//simulate for all requests in the predetermined list
-//same as above but not using random events
-void ridesharing_sim::run_sim_request_list(std::list< std::pair< double, std::pair<ULL, ULL> > > request_list)
+//handle a new request: find the offer (by the dispatcher of the simulation), create the customer and assign it to the transporter of the offer
+void ridesharing_sim::handle_request(ULL request_origin, ULL request_destination, double request_time)
 {
-	double event_time;
+	offer current_best_offer;
 
-	//find time of last request
-	double max_time = 0;
-	next_request_time = 0;
-	if (!request_list.empty())
+	++total_requests;
+
+	//admission control: reject at once if no transporter has room for another customer
+	if (do_admission_control && transporters_with_room == 0)
 	{
-		max_time = request_list.rbegin()->first;
-		next_request_time = request_list.begin()->first;
+		if (do_measurement)
+			measurements.measure_admission(rejected_full_schedules);
+		return;
 	}
 
-	//simulate until last request (does not finish serving all requests!)
-	while (time < max_time)
+	//find the best offer for the request (and measure how long it takes, if enabled)
+	std::chrono::steady_clock::time_point dispatch_start;
+	if (do_dispatch_timing)
+		dispatch_start = std::chrono::steady_clock::now();
+#ifdef DISPATCH_INSTRUMENTATION
+	dispatch_work_counters work_before = dispatch_work_counters::sum_of_all_threads();
+	std::chrono::steady_clock::time_point instrumented_start = std::chrono::steady_clock::now();
+#endif
+
+	if (request_dispatcher != NULL)
+		current_best_offer = request_dispatcher->find_offer(*this, request_origin, request_destination, request_time);
+	else
+		current_best_offer = find_best_offer(request_origin, request_destination, request_time);
+
+	if (do_dispatch_timing)
+		dispatch_latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - dispatch_start).count());
+#ifdef DISPATCH_INSTRUMENTATION
+	if (do_measurement)
 	{
-		if (do_timeseries_output &&
-			next_output_time < next_request_time &&
-			(transporter_event_queue.empty() || next_output_time < transporter_event_queue.top().first) &&
-			(!do_measurement || next_output_time < next_measurement_time)
-			)
-		{
-			event_time = next_output_time;
-			output(event_time);
+		ULL latency_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - instrumented_start).count();
+		dispatch_work_counters work = dispatch_work_counters::sum_of_all_threads();
+		work -= work_before;
+
+		//load of the fleet when the request arrived (counts kept up to date, see update_fleet_load)
+		dispatch_work.measure_request(work, latency_nanoseconds,
+			transporter_list.size() > 0 ? number_of_busy_transporters / (double)transporter_list.size() : 0,
+			number_of_busy_transporters > 0 ? total_planned_stops / (double)number_of_busy_transporters : 0);
+	}
+#endif
 
-			next_output_time += output_time_step;
-		}
-		//if the next event is a measurement event (and measurement is enabled)
-		else if (do_measurement &&
-			next_measurement_time < next_request_time &&
-			(transporter_event_queue.empty() || next_measurement_time < transporter_event_queue.top().first)
-			)
-		{
-			event_time = next_measurement_time;
-			measurements.measure_system_status(transporter_list, event_time);
+	//admission control: reject the request if there is no offer within the limits
+	if (do_admission_control)
+	{
+		admission_decision decision = rejected_no_offer;
+		if (current_best_offer.best_transporter != NULL)
+			decision = admission.check_offer(request_time, current_best_offer.pickup_time, current_best_offer.dropoff_time,
+				network.get_network_distance(request_origin, request_destination) / current_best_offer.best_transporter->get_velocity());
+		if (do_measurement)
+			measurements.measure_admission(decision);
+		if (decision != admitted)
+			return;
+	}
 
-			next_measurement_time += measurement_time_step;
-		}
-		//if the next event is a new_request event
-		else if (transporter_event_queue.empty() || next_request_time < transporter_event_queue.top().first)
-		{
-			ULL event_transporter_index;
-			double next_transporter_event;
+	//assign the request to the best transporter and update the events
+	assign_request(request_origin, request_destination, request_time, current_best_offer, request_time);
+}
 
-			ULL request_origin;
-			ULL request_destination;
+//create the customer of a request and assign it to the transporter of the offer (at the assignment time, e.g. the end of the batch window)
+void ridesharing_sim::assign_request(ULL request_origin, ULL request_destination, double request_time, offer& o, double assignment_time)
+{
+	ULL event_transporter_index;
+	double next_transporter_event;
+
+	assert(o.best_transporter != NULL);
+	event_transporter_index = o.transporter_index;
+	next_transporter_event = transporter_list[event_transporter_index].assign_customer(
+		assignment_time,
+		customers.add_customer(customer(request_origin, request_destination, request_time, network, transporter_list[event_transporter_index], o)),
+		o,
+		customers,
+		network
+	);
+	mark_transporter_modified(event_transporter_index);
+	update_idle_index(event_transporter_index);
+	update_admission_state(event_transporter_index);
+	update_fleet_load(event_transporter_index);
+	if (next_transporter_event >= assignment_time)
+		transporter_event_queue.push(std::make_pair(next_transporter_event, event_transporter_index));
+}
 
-			offer current_offer;
-			offer current_best_offer;
+//find the best offer of all transporters for a request (the dispatcher)
+//the offer is the same as checking all transporters in the order of transporter_list
+offer ridesharing_sim::find_best_offer(ULL request_origin, ULL request_destination, double request_time)
+{
+	offer o;
 
-			event_time = next_request_time;
-			++total_requests;
-			request_origin = request_list.begin()->second.first;
-			request_destination = request_list.begin()->second.second;
+	//offer found in advance, if no transporter that could make an offer as good has changed since
+	if (!do_speculative_dispatch || !take_speculative_offer(request_origin, request_destination, request_time, o))
+		o = find_best_offer(request_origin, request_destination, request_time, dispatch_objective);
 
-			current_best_offer = offer();
-			//find the best offer for the request
-			for (transporter& t : transporter_list)
-			{
-				current_offer = t.best_offer(request_origin, request_destination, event_time, network, current_best_offer);
-				if (current_offer.is_better_offer)
-				{
-					assert(current_offer.dropoff_time <= current_best_offer.dropoff_time);
-					current_best_offer = current_offer;
-				}
-			}
+	//the approximate dispatch has its own comparison with the exact offer
+	if (do_dispatch_check && !do_approximate_dispatch)
+		check_offer(request_origin, request_destination, request_time, o);
 
-			//assign the request to the best transporter and update the events
-			event_transporter_index = current_best_offer.transporter_index;
-			next_transporter_event = transporter_list[event_transporter_index].assign_customer(
-				event_time,
-				customer(request_origin, request_destination, event_time, network, transporter_list[event_transporter_index], current_best_offer),
-				current_best_offer,
-				network
-			);
-			if (next_transporter_event >= event_time)
-				transporter_event_queue.push(std::make_pair(next_transporter_event, event_transporter_index));
+	return(o);
+}
 
-			//update event queue with the next request
-			//erase request from the request list
-			request_list.erase(request_list.begin());
-			if (!request_list.empty())
-				next_request_time = request_list.begin()->first;
-			else	//if no further request, set request time to a larger time (simulation stops here anyways)
-				next_request_time = event_time + std::numeric_limits<double>::max() / 2;
+//compare an offer with the offer of the full scan for the objective of the simulation (its best_offer calls are not counted)
+void ridesharing_sim::check_offer(ULL request_origin, ULL request_destination, double request_time, const offer& o)
+{
+	offer full_scan_offer;
+	switch (dispatch_objective)
+	{
+	case minimal_wait:
+		full_scan_offer = find_best_offer_by_full_scan<minimal_wait_objective>(request_origin, request_destination, request_time);
+		break;
+	case minimal_added_vehicle_time:
+		full_scan_offer = find_best_offer_by_full_scan<minimal_added_vehicle_time_objective>(request_origin, request_destination, request_time);
+		break;
+	case weighted_cost:
+		full_scan_offer = find_best_offer_by_full_scan<default_weighted_cost_objective>(request_origin, request_destination, request_time);
+		break;
+	default:
+		full_scan_offer = find_best_offer_by_full_scan<earliest_dropoff_objective>(request_origin, request_destination, request_time);
+		break;
+	}
 
-		}
-		else {	//the next event is a bus event (bus arriving at a node along its route)
+	++checked_requests;
+	if (o.best_transporter != full_scan_offer.best_transporter || o.pickup_insertion != full_scan_offer.pickup_insertion ||
+		o.dropoff_insertion != full_scan_offer.dropoff_insertion || o.ordering != full_scan_offer.ordering)
+		++different_checked_offers;
+}
 
-			ULL event_transporter_index;
-			double next_transporter_event;
+//best offer of all transporters, each checked in the order of transporter_list (the reference for all other searches)
+template<class objective>
+offer ridesharing_sim::find_best_offer_by_full_scan(ULL request_origin, ULL request_destination, double request_time)
+{
+	offer current_offer;
+	offer current_best_offer;
 
-			event_time = transporter_event_queue.top().first;
-			event_transporter_index = transporter_event_queue.top().second;
-			transporter_event_queue.pop();
+	for (transporter& t : transporter_list)
+	{
+		current_offer = t.best_offer<objective>(request_origin, request_destination, request_time, network, current_best_offer);
+		if (current_offer.is_better_offer)
+			current_best_offer = current_offer;
+	}
 
-			//execute event and handle the next event of the transporter (if any)
-			next_transporter_event = transporter_list[event_transporter_index].execute_event(event_time, network, measurements, total_serviced_requests, do_measurement);
+	return(current_best_offer);
+}
 
-			//update event queue with the next event of the transporter
-			if (next_transporter_event >= event_time)
-				transporter_event_queue.push(std::make_pair(next_transporter_event, event_transporter_index));
+//find the best offer for a given objective
+offer ridesharing_sim::find_best_offer(ULL request_origin, ULL request_destination, double request_time, dispatch_objective_type objective)
+{
+	//the objective is selected once per request, each objective has its own search
+	switch (objective)
+	{
+	case minimal_wait:
+		return(do_approximate_dispatch ? find_approximate_offer<minimal_wait_objective>(request_origin, request_destination, request_time) : find_best_offer_by_objective<minimal_wait_objective>(request_origin, request_destination, request_time));
+	case minimal_added_vehicle_time:
+		return(do_approximate_dispatch ? find_approximate_offer<minimal_added_vehicle_time_objective>(request_origin, request_destination, request_time) : find_best_offer_by_objective<minimal_added_vehicle_time_objective>(request_origin, request_destination, request_time));
+	case weighted_cost:
+		return(do_approximate_dispatch ? find_approximate_offer<default_weighted_cost_objective>(request_origin, request_destination, request_time) : find_best_offer_by_objective<default_weighted_cost_objective>(request_origin, request_destination, request_time));
+	default:
+		return(do_approximate_dispatch ? find_approximate_offer<earliest_dropoff_objective>(request_origin, request_destination, request_time) : find_best_offer_by_objective<earliest_dropoff_objective>(request_origin, request_destination, request_time));
+	}
+}
+
+//approximate offer: only the transporters with the smallest lower bounds for the dropoff time, only pickups before the first stops of each schedule
+//(the selected transporters are checked in the order of transporter_list, ties are broken as in the exact search)
+template<class objective>
+offer ridesharing_sim::find_approximate_offer(ULL request_origin, ULL request_destination, double request_time)
+{
+	collect_dispatch_candidates(request_origin, request_destination, request_time);
+	if (dispatch_candidates.size() > approximate_transporters)
+	{
+		std::nth_element(dispatch_candidates.begin(), dispatch_candidates.begin() + (approximate_transporters - 1), dispatch_candidates.end(), [this](ULL i, ULL j) { return(dispatch_bounds[i] < dispatch_bounds[j] || (dispatch_bounds[i] == dispatch_bounds[j] && i < j)); });
+		dispatch_candidates.resize(approximate_transporters);
+	}
+	std::sort(dispatch_candidates.begin(), dispatch_candidates.end());
+
+	offer current_offer;
+	offer current_best_offer;
+	for (ULL i : dispatch_candidates)
+	{
+		current_offer = transporter_list[i].best_offer<objective>(request_origin, request_destination, request_time, network, current_best_offer, approximate_pickup_positions);
+		++total_best_offer_calls;
+		if (current_offer.is_better_offer)
+			current_best_offer = current_offer;
+	}
+
+	//shadow evaluation: compare with the exact offer (its best_offer calls are not counted)
+	if (shadow_fraction > 0 && std::uniform_real_distribution<double>(0, 1)(shadow_random_generator) < shadow_fraction)
+	{
+		ULL approximate_best_offer_calls = total_best_offer_calls;
+		offer exact_offer = find_best_offer_by_objective<objective>(request_origin, request_destination, request_time);
+		total_best_offer_calls = approximate_best_offer_calls;
+
+		++shadow_requests;
+		if (current_best_offer.best_transporter != exact_offer.best_transporter || current_best_offer.pickup_insertion != exact_offer.pickup_insertion ||
+			current_best_offer.dropoff_insertion != exact_offer.dropoff_insertion || current_best_offer.ordering != exact_offer.ordering)
+			++shadow_different_offers;
+
+		//the loss is only defined if both searches found an offer (with admission control, there may be none)
+		if (current_best_offer.best_transporter != NULL && exact_offer.best_transporter != NULL)
+		{
+			double cost_loss = objective::cost(request_time, current_best_offer.pickup_time, current_best_offer.dropoff_time, current_best_offer.added_vehicle_time) -
+				objective::cost(request_time, exact_offer.pickup_time, exact_offer.dropoff_time, exact_offer.added_vehicle_time);
+			++shadow_compared_offers;
+			shadow_total_cost_loss += cost_loss;
+			shadow_max_cost_loss = std::max(shadow_max_cost_loss, cost_loss);
 		}
+		else if (current_best_offer.best_transporter == NULL && exact_offer.best_transporter != NULL)
+			++shadow_missed_offers;
+	}
 
-		time = event_time;
+	return(current_best_offer);
+}
+
+//turn on approximate dispatch (see find_approximate_offer), a fraction of the requests is also dispatched exactly to measure the difference
+void ridesharing_sim::enable_approximate_dispatch(ULL param_max_transporters, ULL param_max_pickup_positions, double param_shadow_fraction)
+{
+	assert(param_max_transporters > 0 && param_shadow_fraction >= 0 && param_shadow_fraction <= 1);
+
+	do_approximate_dispatch = true;
+	approximate_transporters = param_max_transporters;
+	approximate_pickup_positions = param_max_pickup_positions;
+	shadow_fraction = param_shadow_fraction;
+	shadow_random_generator.seed(0);	//fixed seed: does not draw from the generator of the simulation
+	reset_shadow_statistics();
+}
+
+//turn off approximate dispatch (find the exact best offer)
+void ridesharing_sim::disable_approximate_dispatch()
+{
+	do_approximate_dispatch = false;
+}
+
+//reset the comparison of approximate and exact offers
+void ridesharing_sim::reset_shadow_statistics()
+{
+	shadow_requests = 0;
+	shadow_different_offers = 0;
+	shadow_compared_offers = 0;
+	shadow_missed_offers = 0;
+	shadow_total_cost_loss = 0;
+	shadow_max_cost_loss = 0;
+}
+
+//turn on speculative dispatch with offers found in advance for a window of upcoming requests
+void ridesharing_sim::enable_speculative_dispatch(ULL param_window)
+{
+	assert(param_window > 0);
+
+	do_speculative_dispatch = true;
+	speculation_window = param_window;
+	discard_speculative_offers();
+	speculative_hits = 0;
+	speculative_misses = 0;
+}
+
+//turn off speculative dispatch (requests that were drawn ahead are still used first)
+void ridesharing_sim::disable_speculative_dispatch()
+{
+	do_speculative_dispatch = false;
+	drop_used_upcoming_requests();
+}
+
+//offers are only found in advance for the dispatcher of the simulation with the bound ordered search (see find_speculative_offer)
+bool ridesharing_sim::speculative_dispatch_applies()
+{
+	return(request_dispatcher == NULL && !do_batch_dispatch && !do_approximate_dispatch && dispatch_objective == earliest_dropoff);
+}
+
+//draw the next random requests ahead and find their offers in advance
+//the draws come from the generator of the requests in the same order as when drawing each request when it happens, so the requests are the same
+//(their times are computed as when they happen, unless the request rate changes before)
+void ridesharing_sim::draw_upcoming_requests()
+{
+	double request_time = next_request_time;
+
+	upcoming_requests.clear();
+	upcoming_request_intervals.clear();
+	next_upcoming_request = 0;
+	for (ULL k = 0; k < speculation_window; ++k)
+	{
+		upcoming_requests.push_back(std::make_pair(request_time, network.generate_request(request_random_generator)));
+		upcoming_request_intervals.push_back(exp_dist(request_random_generator));
+		request_time += upcoming_request_intervals.back() / request_rate;
 	}
 
-	//if the simulation is continued with random requests, the next request happens immediately
-	next_request_time = time;
+	speculate_requests(upcoming_requests);
+}
+
+//forget the offers found in advance and the requests drawn ahead that were already used, the others are used next (e.g. when the simulation is restarted)
+void ridesharing_sim::drop_used_upcoming_requests()
+{
+	discard_speculative_offers();
+	upcoming_requests.erase(upcoming_requests.begin(), upcoming_requests.begin() + next_upcoming_request);
+	upcoming_request_intervals.erase(upcoming_request_intervals.begin(), upcoming_request_intervals.begin() + next_upcoming_request);
+	next_upcoming_request = 0;
+}
+
+//find the offers of the given upcoming requests for the current state of the transporters, the requests are split between the dispatch threads
+//from now on, every change of a transporter is recorded (see take_speculative_offer)
+void ridesharing_sim::speculate_requests(std::vector< std::pair< double, std::pair<ULL, ULL> > >& requests)
+{
+	discard_speculative_offers();
+	if (!speculative_dispatch_applies())
+		return;
+
+	++speculation_round;
+	transporter_modified_round.resize(transporter_list.size(), 0);
+	number_of_speculative_requests = requests.size();
+	if (speculative_requests.size() < number_of_speculative_requests)
+		speculative_requests.resize(number_of_speculative_requests);
+	for (ULL k = 0; k < number_of_speculative_requests; ++k)
+	{
+		speculative_requests[k].request_time = requests[k].first;
+		speculative_requests[k].origin = requests[k].second.first;
+		speculative_requests[k].destination = requests[k].second.second;
+	}
+
+	//the neighbour rings are generated on first use, which appends to shared storage: generate them all before the threads read them
+	ULL number_of_threads = dispatch_workers.get_number_of_threads();
+	if (number_of_threads > 1 && network.has_neighbour_rings())
+		network.generate_all_neighbour_rings();
+
+	dispatch_workers.run([this, number_of_threads](ULL thread_index)
+	{
+		for (ULL k = thread_index; k < number_of_speculative_requests; k += number_of_threads)
+			find_speculative_offer(speculative_requests[k]);
+	});
+
+	for (ULL k = 0; k < number_of_speculative_requests; ++k)
+		total_best_offer_calls += speculative_requests[k].best_offer_calls;
+}
+
+//offer for an upcoming request against the current state of the transporters (called on several threads, only reads the simulation,
+//the neighbour rings it uses are generated before by speculate_requests)
+//same candidates and bound ordered search as find_best_offer_by_objective, but with its own buffers
+//transporters with an event before the request are not checked, they change before the request happens anyway
+void ridesharing_sim::find_speculative_offer(speculative_request& r)
+{
+	thread_local std::vector<double> search_bounds;
+	thread_local std::vector<ULL> candidates;
+	thread_local std::vector<ULL> visited;
+	thread_local std::vector< std::vector<ULL> > buckets;
+
+	collect_dispatch_candidates(r.origin, r.destination, r.request_time, search_bounds, candidates);
+	candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [this, &r](ULL i) { return(!transporter_list[i].is_idle() && transporter_list[i].get_current_time() < r.request_time); }), candidates.end());
+
+	//bounds before the search, transporters that are no candidates cannot influence the offer
+	r.bounds.assign(transporter_list.size(), std::numeric_limits<double>::max());
+	for (ULL i : candidates)
+		r.bounds[i] = search_bounds[i];
+
+	buckets.resize(dispatch_buckets.size());
+	r.best_offer_calls = 0;
+	r.speculative_offer = find_best_offer_by_bounds<earliest_dropoff_objective>(r.origin, r.destination, r.request_time, search_bounds, candidates, visited, buckets, r.best_offer_calls);
+}
+
+//offer found in advance for the request, if it is still the best offer (false: the request has to be dispatched again)
+//the offer depends only on the transporters that could come within epsilon of it, it is still valid if each transporter changed since
+//could not do so when the offer was found (or was not checked) and cannot do so now
+//(the dropoff time bounds must also hold for offers that delay other stops, see transporter::dropoff_time_bound)
+bool ridesharing_sim::take_speculative_offer(ULL request_origin, ULL request_destination, double request_time, offer& o)
+{
+	if (!speculative_dispatch_applies())
+		return(false);
+
+	//skip requests that were not dispatched by find_best_offer
+	while (next_speculative_request < number_of_speculative_requests && speculative_requests[next_speculative_request].request_time < request_time)
+		++next_speculative_request;
+	if (next_speculative_request >= number_of_speculative_requests)
+		return(false);
+
+	speculative_request& r = speculative_requests[next_speculative_request];
+	if (r.request_time != request_time || r.origin != request_origin || r.destination != request_destination)
+		return(false);
+	++next_speculative_request;
+
+	bool valid = (r.speculative_offer.best_transporter != NULL);
+	double max_bound = r.speculative_offer.dropoff_time + MACRO_EPSILON;
+	for (ULL i : modified_transporters)
+	{
+		if (!valid)
+			break;
+		if (r.bounds[i] <= max_bound || transporter_list[i].dropoff_time_bound(request_origin, request_destination, request_time, network) <= max_bound)
+			valid = false;
+	}
+
+	if (!valid)
+	{
+		++speculative_misses;
+		return(false);
+	}
+
+	++speculative_hits;
+	o = r.speculative_offer;
+	return(true);
+}
+
+//record that a transporter changed (event or new customer), offers found in advance for later requests may no longer be the best
+void ridesharing_sim::mark_transporter_modified(ULL transporter_index)
+{
+	if (next_speculative_request >= number_of_speculative_requests || transporter_modified_round[transporter_index] == speculation_round)
+		return;
+
+	transporter_modified_round[transporter_index] = speculation_round;
+	modified_transporters.push_back(transporter_index);
+}
+
+//forget all offers found in advance (e.g. if the transporters were replaced)
+void ridesharing_sim::discard_speculative_offers()
+{
+	number_of_speculative_requests = 0;
+	next_speculative_request = 0;
+	modified_transporters.clear();
+}
+
+//re-optimize the schedules of the busy transporters every time step (at most the given number of passes over all moves per schedule)
+void ridesharing_sim::enable_schedule_optimization(double param_time_step, ULL param_max_passes)
+{
+	assert(param_time_step > 0);
+
+	do_schedule_optimization = true;
+	schedule_optimization_time_step = param_time_step;
+	next_schedule_optimization_time = time + schedule_optimization_time_step;
+	schedule_optimization_max_passes = std::max((ULL)1, param_max_passes);
+}
+
+//schedules are only changed by insertions
+void ridesharing_sim::disable_schedule_optimization()
+{
+	do_schedule_optimization = false;
+}
+
+//optimize snapshots of all schedules with at least two stops on the dispatch threads, then reorder the schedules that were improved
+//(in the order of transporter_list, nothing else happens in between, so the snapshots are still current)
+void ridesharing_sim::optimize_schedules()
+{
+	number_of_schedule_snapshots = 0;
+	for (transporter& t : transporter_list)
+	{
+		if (t.get_number_of_planned_stops() < 2)
+			continue;
+
+		if (number_of_schedule_snapshots == schedule_snapshots.size())
+			schedule_snapshots.emplace_back();
+		t.get_schedule_snapshot(schedule_snapshots[number_of_schedule_snapshots]);
+		++number_of_schedule_snapshots;
+	}
+
+	ULL number_of_threads = dispatch_workers.get_number_of_threads();
+	schedule_optimizers.resize(number_of_threads);
+	for (schedule_optimizer& o : schedule_optimizers)
+		o.set_max_passes(schedule_optimization_max_passes);
+
+	dispatch_workers.run([this, number_of_threads](ULL thread_index)
+	{
+		for (ULL k = thread_index; k < number_of_schedule_snapshots; k += number_of_threads)
+			schedule_optimizers[thread_index].optimize(schedule_snapshots[k], network);
+	});
+
+	for (ULL k = 0; k < number_of_schedule_snapshots; ++k)
+	{
+		schedule_snapshot& s = schedule_snapshots[k];
+		if (!s.improved)
+			continue;
+
+		transporter_list[s.transporter_index].reorder_stops(s.ordering, network);
+		mark_transporter_modified(s.transporter_index);
+		update_idle_index(s.transporter_index);
+		update_admission_state(s.transporter_index);
+		update_fleet_load(s.transporter_index);
+
+		if (do_measurement)
+		{
+			++reordered_schedules;
+			total_schedule_time_saved += s.current_end_time - s.end_time;
+		}
+	}
+}
+
+//move customers that are not yet picked up to another transporter every time step
+void ridesharing_sim::enable_reassignment(double param_time_step)
+{
+	assert(param_time_step > 0);
+
+	do_reassignment = true;
+	reassignment_time_step = param_time_step;
+	next_reassignment_time = time + reassignment_time_step;
+}
+
+//customers stay with the transporter they were assigned to
+void ridesharing_sim::disable_reassignment()
+{
+	do_reassignment = false;
+}
+
+//reject requests that exceed the given limits (infinity and max: no limit) instead of assigning every request
+void ridesharing_sim::enable_admission_control(double param_max_wait, double param_max_detour_ratio, ULL param_max_planned_stops)
+{
+	assert(!do_batch_dispatch);
+
+	do_admission_control = true;
+	admission.set_limits(param_max_wait, param_max_detour_ratio, param_max_planned_stops);
+	for (transporter& t : transporter_list)
+		t.set_admission_limits(param_max_wait, param_max_planned_stops);
+	rebuild_admission_state();
+	discard_speculative_offers();
+}
+
+//assign every request
+void ridesharing_sim::disable_admission_control()
+{
+	do_admission_control = false;
+	admission = admission_policy();
+	for (transporter& t : transporter_list)
+		t.set_admission_limits(admission.get_max_wait(), admission.get_max_planned_stops());
+	discard_speculative_offers();
+}
+
+//count the transporters with room for two more stops
+void ridesharing_sim::rebuild_admission_state()
+{
+	transporter_has_room.resize(transporter_list.size());
+	transporters_with_room = 0;
+	for (ULL i = 0; i < transporter_list.size(); ++i)
+	{
+		transporter_has_room[i] = transporter_list[i].has_room_for_customer();
+		if (transporter_has_room[i])
+			++transporters_with_room;
+	}
+}
+
+//update the count after the schedule of a transporter changed
+void ridesharing_sim::update_admission_state(ULL transporter_index)
+{
+	if (!do_admission_control)
+		return;
+
+	bool has_room = transporter_list[transporter_index].has_room_for_customer();
+	if (has_room != transporter_has_room[transporter_index])
+	{
+		transporter_has_room[transporter_index] = has_room;
+		if (has_room)
+			++transporters_with_room;
+		else
+			--transporters_with_room;
+	}
+}
+
+//count the busy transporters and their planned stops (only with DISPATCH_INSTRUMENTATION, for the load of the fleet measured with each request)
+void ridesharing_sim::rebuild_fleet_load()
+{
+#ifdef DISPATCH_INSTRUMENTATION
+	transporter_planned_stops.resize(transporter_list.size());
+	number_of_busy_transporters = 0;
+	total_planned_stops = 0;
+	for (ULL i = 0; i < transporter_list.size(); ++i)
+	{
+		transporter_planned_stops[i] = transporter_list[i].get_number_of_planned_stops();
+		if (transporter_planned_stops[i] > 0)
+			++number_of_busy_transporters;
+		total_planned_stops += transporter_planned_stops[i];
+	}
+#endif
+}
+
+//update the counts after the schedule of a transporter changed
+void ridesharing_sim::update_fleet_load(ULL transporter_index)
+{
+#ifdef DISPATCH_INSTRUMENTATION
+	ULL planned_stops = transporter_list[transporter_index].get_number_of_planned_stops();
+	ULL& indexed_planned_stops = transporter_planned_stops[transporter_index];
+	if (planned_stops > 0 && indexed_planned_stops == 0)
+		++number_of_busy_transporters;
+	else if (planned_stops == 0 && indexed_planned_stops > 0)
+		--number_of_busy_transporters;
+	total_planned_stops += planned_stops;
+	total_planned_stops -= indexed_planned_stops;
+	indexed_planned_stops = planned_stops;
+#endif
+}
+
+//find the best move for every customer that is not yet picked up on the dispatch threads, then take the moves with the largest saving first
+//a transporter that gave up or received a customer is not changed again in this time step (the other moves were evaluated against its previous schedule)
+void ridesharing_sim::reassign_customers(double reassignment_time)
+{
+	//customers of transporters that keep other stops without them
+	number_of_reassignment_moves = 0;
+	for (ULL i = 0; i < transporter_list.size(); ++i)
+	{
+		transporter& t = transporter_list[i];
+		if (t.get_number_of_planned_stops() <= 2)
+			continue;
+
+		for (std::vector< stop >::iterator s = t.get_next_stop(); s != t.no_stop(); ++s)
+		{
+			if (!s->is_pickup())
+				continue;
+
+			if (number_of_reassignment_moves == reassignment_moves.size())
+				reassignment_moves.emplace_back();
+			reassignment_moves[number_of_reassignment_moves].c = s->c;
+			reassignment_moves[number_of_reassignment_moves].from_transporter = i;
+			++number_of_reassignment_moves;
+		}
+	}
+
+	//the neighbour rings are generated on first use, which appends to shared storage: generate them all before the threads read them
+	ULL number_of_threads = dispatch_workers.get_number_of_threads();
+	if (number_of_threads > 1 && network.has_neighbour_rings())
+		network.generate_all_neighbour_rings();
+
+	dispatch_workers.run([this, number_of_threads, reassignment_time](ULL thread_index)
+	{
+		for (ULL k = thread_index; k < number_of_reassignment_moves; k += number_of_threads)
+			evaluate_reassignment(reassignment_moves[k], reassignment_time);
+	});
+
+	//largest saving first (equal savings in the order in which the customers were collected)
+	reassignment_order.clear();
+	for (ULL k = 0; k < number_of_reassignment_moves; ++k)
+		if (reassignment_moves[k].found)
+			reassignment_order.push_back(k);
+	std::stable_sort(reassignment_order.begin(), reassignment_order.end(), [this](ULL a, ULL b) { return(reassignment_moves[a].saving > reassignment_moves[b].saving); });
+
+	transporter_reassigned.assign(transporter_list.size(), false);
+	for (ULL k : reassignment_order)
+	{
+		reassignment_move& m = reassignment_moves[k];
+		ULL to_transporter = m.new_offer.transporter_index;
+		if (transporter_reassigned[m.from_transporter] || transporter_reassigned[to_transporter])
+			continue;
+
+		customer& c = customers.get_customer(m.c);
+		transporter_list[m.from_transporter].remove_customer(m.c, network);
+
+		//the stops keep the times promised to the customer
+		offer o = m.new_offer;
+		o.pickup_time = c.get_offer_pickup_time();
+		o.dropoff_time = c.get_offer_dropoff_time();
+		double next_transporter_event = transporter_list[to_transporter].assign_customer(reassignment_time, m.c, o, customers, network);
+		if (next_transporter_event >= reassignment_time)
+			transporter_event_queue.push(std::make_pair(next_transporter_event, to_transporter));
+
+		for (ULL i : { m.from_transporter, to_transporter })
+		{
+			mark_transporter_modified(i);
+			update_idle_index(i);
+			update_admission_state(i);
+			update_fleet_load(i);
+			transporter_reassigned[i] = true;
+		}
+
+		if (do_measurement)
+		{
+			++reassigned_customers;
+			total_reassignment_time_saved += m.saving;
+		}
+	}
+}
+
+//best transporter to take over a customer that is not yet picked up (called on several threads, only reads the simulation)
+//the insertion with the least added vehicle time is used, or the earliest dropoff if that is later than promised
+//only the candidates of the search for a request are checked (with the idle index: the idle transporters closest to the origin, see collect_dispatch_candidates),
+//in the order of transporter_list, and only if their dropoff time bound keeps the promised dropoff time
+void ridesharing_sim::evaluate_reassignment(reassignment_move& m, double reassignment_time)
+{
+	thread_local std::vector<double> bounds;
+	thread_local std::vector<ULL> candidates;
+
+	customer& c = customers.get_customer(m.c);
+	double removal_saving = transporter_list[m.from_transporter].removal_saving(m.c, network);
+
+	m.found = false;
+	m.saving = 0;
+
+	//no other transporter can take the customer with less than no added vehicle time
+	if (removal_saving <= MACRO_EPSILON)
+		return;
+
+	collect_dispatch_candidates(c.get_origin(), c.get_destination(), reassignment_time, bounds, candidates);
+	candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&c, &m](ULL j) { return(j == m.from_transporter || bounds[j] > c.get_offer_dropoff_time() + MACRO_EPSILON); }), candidates.end());
+	std::sort(candidates.begin(), candidates.end());
+
+	for (ULL j : candidates)
+	{
+		transporter& t = transporter_list[j];
+
+		//the transporter cannot reach the origin in time
+		if (std::max(t.get_current_time(), reassignment_time) + network.get_network_distance(t.get_current_location(), c.get_origin()) / t.get_velocity() > c.get_offer_pickup_time() + MACRO_EPSILON)
+			continue;
+
+		auto keeps_promise = [&c](const offer& o)
+		{
+			return(o.best_transporter != NULL && o.pickup_time <= c.get_offer_pickup_time() + MACRO_EPSILON && o.dropoff_time <= c.get_offer_dropoff_time() + MACRO_EPSILON);
+		};
+
+		offer no_offer;
+		offer o = t.best_offer<minimal_added_vehicle_time_objective>(c.get_origin(), c.get_destination(), reassignment_time, network, no_offer);
+		if (!keeps_promise(o))
+			o = t.best_offer<earliest_dropoff_objective>(c.get_origin(), c.get_destination(), reassignment_time, network, no_offer);
+		if (!keeps_promise(o))
+			continue;
+
+		if (removal_saving - o.added_vehicle_time > m.saving + MACRO_EPSILON)
+		{
+			m.found = true;
+			m.saving = removal_saving - o.added_vehicle_time;
+			m.new_offer = o;
+		}
+	}
+}
+
+//best offer of all transporters for the given objective
+//the bound ordered search (and the idle index) is only used if the cost is the dropoff time, otherwise all transporters are checked
+template<class objective>
+offer ridesharing_sim::find_best_offer_by_objective(ULL request_origin, ULL request_destination, double request_time)
+{
+	offer current_offer;
+	offer current_best_offer;
+
+	if (dispatch_workers.get_number_of_threads() > 1)
+		return(find_best_offer_parallel<objective>(request_origin, request_destination, request_time));
+
+	if (!do_bound_ordered_search || !objective::dropoff_time_is_cost)
+	{
+		//idle transporters are evaluated together, only those that can come within epsilon of the best idle offer can influence the choice
+		double max_idle_cost = std::numeric_limits<double>::max();
+		if (do_idle_index)
+		{
+			evaluate_idle_transporters(request_origin, request_destination, request_time);
+			idle_costs.resize(idle_fleet_transporters.size());
+			for (ULL k = 0; k < idle_costs.size(); ++k)
+				idle_costs[k] = objective::cost(request_time, idle_pickup_times[k], idle_dropoff_times[k], idle_added_vehicle_times[k]);
+			//idle transporters that cannot pick up within the maximal wait make no offer (see transporter::idle_offer)
+			if (do_admission_control)
+				for (ULL k = 0; k < idle_costs.size(); ++k)
+					if (idle_pickup_times[k] - request_time > admission.get_max_wait() + MACRO_EPSILON)
+						idle_costs[k] = std::numeric_limits<double>::max();
+			max_idle_cost = min_idle_cost() + MACRO_EPSILON;
+		}
+
+		for (ULL i = 0; i < transporter_list.size(); ++i)
+		{
+			transporter& t = transporter_list[i];
+			if (do_idle_index && idle_fleet_position[i] != (ULL)-1)
+			{
+				ULL k = idle_fleet_position[i];
+				if (idle_costs[k] > max_idle_cost)
+					continue;
+				current_offer = t.idle_offer<objective>(request_time, idle_pickup_times[k], idle_dropoff_times[k], idle_added_vehicle_times[k], current_best_offer);
+			}
+			else
+				current_offer = t.best_offer<objective>(request_origin, request_destination, request_time, network, current_best_offer);
+			++total_best_offer_calls;
+			if (current_offer.is_better_offer)
+			{
+				assert(!objective::dropoff_time_is_cost || current_offer.dropoff_time <= current_best_offer.dropoff_time);
+				current_best_offer = current_offer;
+			}
+		}
+
+		return(current_best_offer);
+	}
+
+	//candidate transporters and lower bounds for their dropoff time
+	collect_dispatch_candidates(request_origin, request_destination, request_time);
+	return(find_best_offer_by_bounds<objective>(request_origin, request_destination, request_time, dispatch_bounds, dispatch_candidates, visited_transporters, dispatch_buckets, total_best_offer_calls));
+}
+
+//bound ordered search over the given candidates with the given buffers (bounds are tightened, only if the cost is the dropoff time)
+template<class objective>
+offer ridesharing_sim::find_best_offer_by_bounds(ULL request_origin, ULL request_destination, double request_time, std::vector<double>& bounds, std::vector<ULL>& candidates,
+	std::vector<ULL>& visited, std::vector< std::vector<ULL> >& buckets, ULL& best_offer_calls)
+{
+	offer current_offer;
+	offer current_best_offer;
+
+	//remember the candidates with the smallest bound
+	double min_bound = std::numeric_limits<double>::max();
+	visited.clear();
+	for (ULL i : candidates)
+	{
+		if (bounds[i] < min_bound - MACRO_EPSILON)
+			visited.clear();
+		min_bound = std::min(min_bound, bounds[i]);
+		if (bounds[i] <= min_bound + MACRO_EPSILON)
+			visited.push_back(i);
+	}
+	visited.erase(std::remove_if(visited.begin(), visited.end(), [&bounds, min_bound](ULL i) { return(bounds[i] > min_bound + MACRO_EPSILON); }), visited.end());
+
+	//first pass: check the transporters with the smallest bound first (typically idle transporters, for which the bound is the offer)
+	for (ULL i : visited)
+	{
+		current_offer = transporter_list[i].best_offer<objective>(request_origin, request_destination, request_time, network, current_best_offer);
+		++best_offer_calls;
+		//no offer of the transporter is better than the returned offer or the previous best offer (within epsilon), tighten its bound
+		bounds[i] = std::max(bounds[i], std::min(current_offer.dropoff_time, current_best_offer.dropoff_time) - MACRO_EPSILON);
+		if (current_offer.is_better_offer)
+			current_best_offer = current_offer;
+	}
+
+	//then all other transporters that can still reach the best offer in order of increasing bound (sorted into buckets of equal width first)
+	//until no remaining transporter can reach the best offer
+	double max_bound = current_best_offer.dropoff_time + MACRO_EPSILON;
+	double bucket_width = (max_bound - min_bound) / buckets.size();
+	for (std::vector<ULL>& bucket : buckets)
+		bucket.clear();
+	for (ULL i : candidates)
+	{
+		if (bounds[i] > min_bound + MACRO_EPSILON && bounds[i] <= max_bound)
+			buckets[std::min((ULL)((bounds[i] - min_bound) / bucket_width), (ULL)buckets.size() - 1)].push_back(i);
+	}
+
+	bool better_offer_possible = true;
+	for (std::vector<ULL>& bucket : buckets)
+	{
+		std::sort(bucket.begin(), bucket.end(), [&bounds](ULL i, ULL j) { return(bounds[i] < bounds[j] || (bounds[i] == bounds[j] && i < j)); });
+		for (ULL i : bucket)
+		{
+			if (bounds[i] > current_best_offer.dropoff_time + MACRO_EPSILON)
+			{
+				better_offer_possible = false;
+				break;
+			}
+
+			current_offer = transporter_list[i].best_offer<objective>(request_origin, request_destination, request_time, network, current_best_offer);
+			++best_offer_calls;
+			bounds[i] = std::max(bounds[i], std::min(current_offer.dropoff_time, current_best_offer.dropoff_time) - MACRO_EPSILON);
+			if (current_offer.is_better_offer)
+				current_best_offer = current_offer;
+
+			visited.push_back(i);
+		}
+
+		if (!better_offer_possible)
+			break;
+	}
+
+	//all other transporters cannot come within epsilon of the best offer, they never influence the choice
+	return(find_best_offer_among_visited<objective>(request_origin, request_destination, request_time, bounds, visited, current_best_offer.dropoff_time, best_offer_calls));
+}
+
+//second pass of the bound ordered search: check the visited transporters that can still reach the best offer (with the tightened bounds)
+//in the order of transporter_list to reproduce the tie breaking of the full search
+template<class objective>
+offer ridesharing_sim::find_best_offer_among_visited(ULL request_origin, ULL request_destination, double request_time, std::vector<double>& bounds, std::vector<ULL>& visited,
+	double best_dropoff_time, ULL& best_offer_calls)
+{
+	offer current_offer;
+	offer current_best_offer;
+
+	std::sort(visited.begin(), visited.end());
+	for (ULL transporter_index : visited)
+	{
+		transporter& t = transporter_list[transporter_index];
+		if (bounds[transporter_index] > best_dropoff_time + MACRO_EPSILON || bounds[transporter_index] > current_best_offer.dropoff_time + MACRO_EPSILON)
+			continue;
+
+		current_offer = t.best_offer<objective>(request_origin, request_destination, request_time, network, current_best_offer);
+		++best_offer_calls;
+		if (current_offer.is_better_offer)
+		{
+			assert(current_offer.dropoff_time <= current_best_offer.dropoff_time);
+			current_best_offer = current_offer;
+		}
+	}
+
+	return(current_best_offer);
+}
+
+//collect the transporters that need to be checked for a request and a lower bound for their dropoff time
+//without the idle index these are all transporters
+//with the idle index: all busy transporters and only a few idle transporters per node (all idle transporters at the same node with the same velocity make the same offer)
+//idle transporters are searched outward from the origin until no idle transporter can make a better offer
+void ridesharing_sim::collect_dispatch_candidates(ULL request_origin, ULL request_destination, double request_time)
+{
+	collect_dispatch_candidates(request_origin, request_destination, request_time, dispatch_bounds, dispatch_candidates);
+}
+
+//same with the given buffers (bounds are indexed by transporter)
+void ridesharing_sim::collect_dispatch_candidates(ULL request_origin, ULL request_destination, double request_time, std::vector<double>& bounds, std::vector<ULL>& candidates)
+{
+	bounds.resize(transporter_list.size());
+	candidates.clear();
+
+	if (!do_idle_index)
+	{
+		for (ULL i = 0; i < transporter_list.size(); ++i)
+		{
+			bounds[i] = transporter_list[i].dropoff_time_bound(request_origin, request_destination, request_time, network);
+			candidates.push_back(i);
+		}
+		return;
+	}
+
+	for (ULL i : busy_transporters)
+	{
+		bounds[i] = transporter_list[i].dropoff_time_bound(request_origin, request_destination, request_time, network);
+		candidates.push_back(i);
+	}
+	collect_idle_dispatch_candidates(request_origin, request_destination, request_time, bounds, candidates);
+}
+
+//add the idle transporters that need to be checked for a request to the candidates (only with the idle index)
+void ridesharing_sim::collect_idle_dispatch_candidates(ULL request_origin, ULL request_destination, double request_time, std::vector<double>& bounds, std::vector<ULL>& candidates)
+{
+	ULL number_of_busy_candidates = candidates.size();
+
+	//the bound of an idle transporter is its offer, idle transporters further away than the best idle offer cannot make a better offer
+	double best_idle_offer = std::numeric_limits<double>::max();
+	double trip_time = network.get_network_distance(request_origin, request_destination) / max_velocity;
+	bool idle_search_complete = false;
+	if (network.has_neighbour_rings())
+	{
+		neighbour_ring ring = network.get_neighbour_ring(request_origin);
+		for (const ring_entry& e : ring)
+		{
+			if (request_time + e.distance / max_velocity + trip_time > best_idle_offer + MACRO_EPSILON)
+			{
+				idle_search_complete = true;
+				break;
+			}
+			add_idle_dispatch_candidates(e.node_index, request_origin, request_destination, request_time, best_idle_offer, bounds, candidates);
+		}
+
+		//nodes outside of the ring are at least as far away as the reach of the ring
+		if (request_time + ring.reach / max_velocity + trip_time > best_idle_offer + MACRO_EPSILON)
+			idle_search_complete = true;
+	}
+
+	//if the ring was not large enough, check all nodes with idle transporters
+	if (!idle_search_complete)
+	{
+		candidates.resize(number_of_busy_candidates);
+		for (ULL node : nodes_with_idle_transporters)
+			add_idle_dispatch_candidates(node, request_origin, request_destination, request_time, best_idle_offer, bounds, candidates);
+	}
+}
+
+//add the idle transporters at a node that represent all idle transporters with the same offer (same velocity)
+//the full search takes the last of several idle transporters with equal offers, unless a busy transporter with the same offer was checked before the first one
+//so only the first and the last transporter of each velocity can influence the choice
+void ridesharing_sim::add_idle_dispatch_candidates(ULL node, ULL request_origin, ULL request_destination, double request_time, double& best_idle_offer, std::vector<double>& bounds, std::vector<ULL>& candidates)
+{
+	ULL first_candidate_at_node = candidates.size();
+	for (ULL i : idle_transporters_at_node[node])
+	{
+		bool represented = false;
+		for (ULL k = first_candidate_at_node; k < candidates.size(); k += 2)
+		{
+			if (transporter_list[candidates[k]].get_velocity() == transporter_list[i].get_velocity())
+			{
+				candidates[k] = std::min(candidates[k], i);
+				candidates[k + 1] = std::max(candidates[k + 1], i);
+				represented = true;
+				break;
+			}
+		}
+		if (!represented)
+		{
+			candidates.push_back(i);
+			candidates.push_back(i);
+		}
+	}
+
+	//remove duplicates (only one transporter of a velocity) and compute the offers
+	ULL last_candidate = first_candidate_at_node;
+	for (ULL k = first_candidate_at_node; k < candidates.size(); k += 2)
+	{
+		for (ULL i : { candidates[k], candidates[k + 1] })
+		{
+			if (last_candidate > first_candidate_at_node && candidates[last_candidate - 1] == i)
+				continue;
+
+			candidates[last_candidate] = i;
+			++last_candidate;
+			bounds[i] = transporter_list[i].dropoff_time_bound(request_origin, request_destination, request_time, network);
+			best_idle_offer = std::min(best_idle_offer, bounds[i]);
+		}
+	}
+	candidates.resize(last_candidate);
+}
+
+//turn on the index of idle transporters by node
+void ridesharing_sim::enable_idle_index()
+{
+	do_idle_index = true;
+	rebuild_idle_index();
+}
+
+//turn off the index of idle transporters (check every transporter)
+void ridesharing_sim::disable_idle_index()
+{
+	do_idle_index = false;
+}
+
+//sort all transporters into the index (busy or idle at their current node)
+//must be called after transporters were changed outside of the simulation (e.g. reset), this is done at the start of every run
+void ridesharing_sim::rebuild_idle_index()
+{
+	idle_transporters_at_node.assign(network.get_number_of_nodes(), std::vector<ULL>());
+	nodes_with_idle_transporters.clear();
+	node_index_position.assign(network.get_number_of_nodes(), -1);
+	busy_transporters.clear();
+	transporter_index_position.assign(transporter_list.size(), -1);
+	transporter_indexed_node.assign(transporter_list.size(), -1);
+	idle_fleet_transporters.clear();
+	idle_fleet_distance_rows.clear();
+	idle_fleet_times.clear();
+	idle_fleet_velocities.clear();
+	idle_fleet_position.assign(transporter_list.size(), -1);
+
+	max_velocity = 0;
+	for (ULL i = 0; i < transporter_list.size(); ++i)
+	{
+		max_velocity = std::max(max_velocity, transporter_list[i].get_velocity());
+		insert_into_idle_index(i);
+	}
+
+}
+
+//move a transporter within the index if it changed from idle to busy or vice versa
+void ridesharing_sim::update_idle_index(ULL transporter_index)
+{
+	if (!do_idle_index)
+		return;
+
+	bool indexed_as_idle = (transporter_indexed_node[transporter_index] != (ULL)-1);
+	if (indexed_as_idle != transporter_list[transporter_index].is_idle())
+	{
+		remove_from_idle_index(transporter_index);
+		insert_into_idle_index(transporter_index);
+	}
+	assert(!indexed_as_idle || !transporter_list[transporter_index].is_idle() || transporter_indexed_node[transporter_index] == transporter_list[transporter_index].get_current_location());
+}
+
+//add a transporter to the list of busy transporters or of idle transporters at its node
+void ridesharing_sim::insert_into_idle_index(ULL transporter_index)
+{
+	transporter& t = transporter_list[transporter_index];
+	if (t.is_idle())
+	{
+		ULL node = t.get_current_location();
+		if (idle_transporters_at_node[node].empty())
+		{
+			node_index_position[node] = nodes_with_idle_transporters.size();
+			nodes_with_idle_transporters.push_back(node);
+		}
+		transporter_index_position[transporter_index] = idle_transporters_at_node[node].size();
+		transporter_indexed_node[transporter_index] = node;
+		idle_transporters_at_node[node].push_back(transporter_index);
+
+		idle_fleet_position[transporter_index] = idle_fleet_transporters.size();
+		idle_fleet_transporters.push_back(transporter_index);
+		idle_fleet_distance_rows.push_back(node * network.get_number_of_nodes());
+		idle_fleet_times.push_back(t.get_current_time());
+		idle_fleet_velocities.push_back(t.get_velocity());
+	}
+	else
+	{
+		transporter_index_position[transporter_index] = busy_transporters.size();
+		transporter_indexed_node[transporter_index] = -1;
+		busy_transporters.push_back(transporter_index);
+	}
+}
+
+//remove a transporter from the index (swap with the last entry of its list)
+void ridesharing_sim::remove_from_idle_index(ULL transporter_index)
+{
+	ULL node = transporter_indexed_node[transporter_index];
+	std::vector<ULL>& list = (node == (ULL)-1) ? busy_transporters : idle_transporters_at_node[node];
+
+	ULL position = transporter_index_position[transporter_index];
+	assert(list[position] == transporter_index);
+	list[position] = list.back();
+	transporter_index_position[list[position]] = position;
+	list.pop_back();
+
+	//remove the transporter from the arrays of idle transporters
+	if (node != (ULL)-1)
+	{
+		ULL idle_position = idle_fleet_position[transporter_index];
+		idle_fleet_transporters[idle_position] = idle_fleet_transporters.back();
+		idle_fleet_distance_rows[idle_position] = idle_fleet_distance_rows.back();
+		idle_fleet_times[idle_position] = idle_fleet_times.back();
+		idle_fleet_velocities[idle_position] = idle_fleet_velocities.back();
+		idle_fleet_position[idle_fleet_transporters[idle_position]] = idle_position;
+		idle_fleet_transporters.pop_back();
+		idle_fleet_distance_rows.pop_back();
+		idle_fleet_times.pop_back();
+		idle_fleet_velocities.pop_back();
+		idle_fleet_position[transporter_index] = -1;
+	}
+
+	//remove the node from the list of nodes with idle transporters if it was the last one
+	if (node != (ULL)-1 && list.empty())
+	{
+		ULL node_position = node_index_position[node];
+		nodes_with_idle_transporters[node_position] = nodes_with_idle_transporters.back();
+		node_index_position[nodes_with_idle_transporters[node_position]] = node_position;
+		nodes_with_idle_transporters.pop_back();
+		node_index_position[node] = -1;
+	}
+}
+
+//pickup and dropoff time and additional driving time of every idle transporter for a request (same arithmetic as the idle case of transporter::best_offer)
+//with AVX-512 or AVX2 eight or four transporters at a time, the distances to the origin are gathered from the distance matrix
+void ridesharing_sim::evaluate_idle_transporters(ULL request_origin, ULL request_destination, double request_time)
+{
+	ULL number_of_idle_transporters = idle_fleet_transporters.size();
+	idle_pickup_times.resize(number_of_idle_transporters);
+	idle_dropoff_times.resize(number_of_idle_transporters);
+	idle_added_vehicle_times.resize(number_of_idle_transporters);
+
+	const double* distances = network.get_distance_matrix();
+	double trip_distance = network.get_network_distance(request_origin, request_destination);
+
+	ULL k = 0;
+#if defined(__AVX512F__)
+	__m512i origin_8 = _mm512_set1_epi64(request_origin);
+	__m512d request_time_8 = _mm512_set1_pd(request_time);
+	__m512d trip_distance_8 = _mm512_set1_pd(trip_distance);
+	for (; k + 8 <= number_of_idle_transporters; k += 8)
+	{
+		__m512d pickup_distance = _mm512_i64gather_pd(_mm512_add_epi64(_mm512_loadu_si512(&idle_fleet_distance_rows[k]), origin_8), distances, 8);
+		__m512d velocity = _mm512_loadu_pd(&idle_fleet_velocities[k]);
+		__m512d pickup_drive = _mm512_div_pd(pickup_distance, velocity);
+		__m512d trip_drive = _mm512_div_pd(trip_distance_8, velocity);
+		__m512d pickup_time = _mm512_add_pd(_mm512_max_pd(_mm512_loadu_pd(&idle_fleet_times[k]), request_time_8), pickup_drive);
+		_mm512_storeu_pd(&idle_pickup_times[k], pickup_time);
+		_mm512_storeu_pd(&idle_dropoff_times[k], _mm512_add_pd(pickup_time, trip_drive));
+		_mm512_storeu_pd(&idle_added_vehicle_times[k], _mm512_add_pd(pickup_drive, trip_drive));
+	}
+#elif defined(__AVX2__)
+	__m256i origin_4 = _mm256_set1_epi64x(request_origin);
+	__m256d request_time_4 = _mm256_set1_pd(request_time);
+	__m256d trip_distance_4 = _mm256_set1_pd(trip_distance);
+	for (; k + 4 <= number_of_idle_transporters; k += 4)
+	{
+		__m256d pickup_distance = _mm256_i64gather_pd(distances, _mm256_add_epi64(_mm256_loadu_si256((const __m256i*)&idle_fleet_distance_rows[k]), origin_4), 8);
+		__m256d velocity = _mm256_loadu_pd(&idle_fleet_velocities[k]);
+		__m256d pickup_drive = _mm256_div_pd(pickup_distance, velocity);
+		__m256d trip_drive = _mm256_div_pd(trip_distance_4, velocity);
+		__m256d pickup_time = _mm256_add_pd(_mm256_max_pd(_mm256_loadu_pd(&idle_fleet_times[k]), request_time_4), pickup_drive);
+		_mm256_storeu_pd(&idle_pickup_times[k], pickup_time);
+		_mm256_storeu_pd(&idle_dropoff_times[k], _mm256_add_pd(pickup_time, trip_drive));
+		_mm256_storeu_pd(&idle_added_vehicle_times[k], _mm256_add_pd(pickup_drive, trip_drive));
+	}
+#endif
+	for (; k < number_of_idle_transporters; ++k)
+	{
+		double pickup_drive = distances[idle_fleet_distance_rows[k] + request_origin] / idle_fleet_velocities[k];
+		double trip_drive = trip_distance / idle_fleet_velocities[k];
+		idle_pickup_times[k] = std::max(idle_fleet_times[k], request_time) + pickup_drive;
+		idle_dropoff_times[k] = idle_pickup_times[k] + trip_drive;
+		idle_added_vehicle_times[k] = pickup_drive + trip_drive;
+	}
+}
+
+//smallest cost of the offers of the idle transporters (max if there are none)
+double ridesharing_sim::min_idle_cost()
+{
+	double min_cost = std::numeric_limits<double>::max();
+
+	ULL k = 0;
+#if defined(__AVX512F__)
+	__m512d min_cost_8 = _mm512_set1_pd(min_cost);
+	for (; k + 8 <= idle_costs.size(); k += 8)
+		min_cost_8 = _mm512_min_pd(min_cost_8, _mm512_loadu_pd(&idle_costs[k]));
+	min_cost = _mm512_reduce_min_pd(min_cost_8);
+#elif defined(__AVX2__)
+	__m256d min_cost_4 = _mm256_set1_pd(min_cost);
+	for (; k + 4 <= idle_costs.size(); k += 4)
+		min_cost_4 = _mm256_min_pd(min_cost_4, _mm256_loadu_pd(&idle_costs[k]));
+	double lanes[4];
+	_mm256_storeu_pd(lanes, min_cost_4);
+	min_cost = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+#endif
+	for (; k < idle_costs.size(); ++k)
+		min_cost = std::min(min_cost, idle_costs[k]);
+
+	return(min_cost);
+}
+
+//parallel dispatcher: each thread checks a contiguous part of transporter_list in order, the best dropoff time found so far is shared between threads
+//transporters that cannot come within epsilon of the best offer found by any thread are skipped (they never influence the choice, only if the cost is the dropoff time)
+//this needs a lower bound that also holds if the offer delays other stops (see transporter::dropoff_time_bound), otherwise the offer depends on the timing of the threads
+//the best offers of all parts are combined in the order of transporter_list (same tie breaking as the sequential search)
+template<class objective>
+offer ridesharing_sim::find_best_offer_parallel(ULL request_origin, ULL request_destination, double request_time)
+{
+	ULL number_of_threads = dispatch_workers.get_number_of_threads();
+	std::atomic<double> shared_best_dropoff_time(std::numeric_limits<double>::max());
+
+	dispatch_workers.run([this, request_origin, request_destination, request_time, number_of_threads, &shared_best_dropoff_time](ULL thread_index)
+	{
+		ULL first = transporter_list.size() * thread_index / number_of_threads;
+		ULL last = transporter_list.size() * (thread_index + 1) / number_of_threads;
+
+		offer current_offer;
+		offer part_best_offer;
+		ULL best_offer_calls = 0;
+		for (ULL i = first; i < last; ++i)
+		{
+			if (objective::dropoff_time_is_cost)
+			{
+				double bound = transporter_list[i].dropoff_time_bound(request_origin, request_destination, request_time, network);
+				if (bound > std::min(part_best_offer.dropoff_time, shared_best_dropoff_time.load(std::memory_order_relaxed)) + MACRO_EPSILON)
+					continue;
+			}
+
+			current_offer = transporter_list[i].best_offer<objective>(request_origin, request_destination, request_time, network, part_best_offer);
+			++best_offer_calls;
+			if (current_offer.is_better_offer)
+			{
+				part_best_offer = current_offer;
+
+				//share the new best dropoff time with the other threads
+				if (objective::dropoff_time_is_cost)
+				{
+					double shared_dropoff_time = shared_best_dropoff_time.load(std::memory_order_relaxed);
+					while (part_best_offer.dropoff_time < shared_dropoff_time && !shared_best_dropoff_time.compare_exchange_weak(shared_dropoff_time, part_best_offer.dropoff_time, std::memory_order_relaxed))
+						;
+				}
+			}
+		}
+
+		dispatch_part_best_offers[thread_index] = part_best_offer;
+		dispatch_part_best_offer_calls[thread_index] = best_offer_calls;
+	});
+
+	//combine the parts in order: the best transporter of each part makes its offer again, given the best offer of all previous parts
+	offer current_offer;
+	offer current_best_offer;
+	for (ULL thread_index = 0; thread_index < number_of_threads; ++thread_index)
+	{
+		total_best_offer_calls += dispatch_part_best_offer_calls[thread_index];
+		if (dispatch_part_best_offers[thread_index].best_transporter == NULL)
+			continue;
+
+		current_offer = dispatch_part_best_offers[thread_index].best_transporter->best_offer<objective>(request_origin, request_destination, request_time, network, current_best_offer);
+		++total_best_offer_calls;
+		if (current_offer.is_better_offer)
+		{
+			assert(!objective::dropoff_time_is_cost || current_offer.dropoff_time <= current_best_offer.dropoff_time);
+			current_best_offer = current_offer;
+		}
+	}
+
+	return(current_best_offer);
+}
+
+//find the k best offers for the objective of the simulation
+void ridesharing_sim::find_best_offers(ULL request_origin, ULL request_destination, double request_time, ULL k, std::vector<offer>& offers)
+{
+	assert(k > 0);
+
+	switch (dispatch_objective)
+	{
+	case minimal_wait:
+		find_best_offers_by_objective<minimal_wait_objective>(request_origin, request_destination, request_time, k, offers);
+		break;
+	case minimal_added_vehicle_time:
+		find_best_offers_by_objective<minimal_added_vehicle_time_objective>(request_origin, request_destination, request_time, k, offers);
+		break;
+	case weighted_cost:
+		find_best_offers_by_objective<default_weighted_cost_objective>(request_origin, request_destination, request_time, k, offers);
+		break;
+	default:
+		find_best_offers_by_objective<earliest_dropoff_objective>(request_origin, request_destination, request_time, k, offers);
+		break;
+	}
+}
+
+//k best offers: the offers are ranked by cost, tie cost and transporter index (the same offers for any number of threads)
+//each thread checks its part of transporter_list in order of the lower bounds for the dropoff time, the best offer of each transporter is put into a heap of at most k offers
+//once the heap is full, a transporter only makes an offer if it is better than the worst offer in the heap (passed to best_offer as the offer to beat)
+//if the cost is the dropoff time, the k-th best dropoff time of any thread is shared: transporters whose bound is later cannot be among the k best offers
+template<class objective>
+void ridesharing_sim::find_best_offers_by_objective(ULL request_origin, ULL request_destination, double request_time, ULL k, std::vector<offer>& offers)
+{
+	ULL number_of_threads = dispatch_workers.get_number_of_threads();
+	std::atomic<double> shared_kth_dropoff_time(std::numeric_limits<double>::max());
+
+	//rank of the offers: cost, tie cost, then the transporter with the larger occupancy (as in transporter::best_offer), then the smaller index
+	auto ranks_before = [request_time](const offer& o1, const offer& o2)
+	{
+		double c1 = objective::cost(request_time, o1.pickup_time, o1.dropoff_time, o1.added_vehicle_time);
+		double c2 = objective::cost(request_time, o2.pickup_time, o2.dropoff_time, o2.added_vehicle_time);
+		if (c1 != c2)
+			return(c1 < c2);
+		double t1 = objective::tie_cost(request_time, o1.pickup_time, o1.dropoff_time, o1.added_vehicle_time);
+		double t2 = objective::tie_cost(request_time, o2.pickup_time, o2.dropoff_time, o2.added_vehicle_time);
+		if (t1 != t2)
+			return(t1 < t2);
+		if (o1.best_transporter->get_occupancy() != o2.best_transporter->get_occupancy())
+			return(o1.best_transporter->get_occupancy() > o2.best_transporter->get_occupancy());
+		return(o1.transporter_index < o2.transporter_index);
+	};
+
+	dispatch_workers.run([this, request_origin, request_destination, request_time, k, number_of_threads, &shared_kth_dropoff_time, &ranks_before](ULL thread_index)
+	{
+		ULL first = transporter_list.size() * thread_index / number_of_threads;
+		ULL last = transporter_list.size() * (thread_index + 1) / number_of_threads;
+
+		std::vector< std::pair<double, ULL> >& candidates = dispatch_part_candidates[thread_index];
+		candidates.clear();
+		for (ULL i = first; i < last; ++i)
+			candidates.push_back(std::make_pair(objective::dropoff_time_is_cost ? transporter_list[i].dropoff_time_bound(request_origin, request_destination, request_time, network) : 0, i));
+		if (objective::dropoff_time_is_cost)
+			std::sort(candidates.begin(), candidates.end());
+
+		//the worst offer is at the front of the heap (the largest by rank)
+		std::vector<offer>& heap = dispatch_part_offer_heaps[thread_index];
+		heap.clear();
+		ULL best_offer_calls = 0;
+		for (std::pair<double, ULL>& candidate : candidates)
+		{
+			offer no_offer;
+			bool heap_is_full = (heap.size() == k);
+			if (objective::dropoff_time_is_cost && candidate.first > std::min(heap_is_full ? heap.front().dropoff_time : std::numeric_limits<double>::max(), shared_kth_dropoff_time.load(std::memory_order_relaxed)) + MACRO_EPSILON)
+				break;
+
+			offer current_offer = transporter_list[candidate.second].best_offer<objective>(request_origin, request_destination, request_time, network, heap_is_full ? heap.front() : no_offer);
+			++best_offer_calls;
+			if (!current_offer.is_better_offer || (heap_is_full && !ranks_before(current_offer, heap.front())))
+				continue;
+
+			if (heap_is_full)
+			{
+				std::pop_heap(heap.begin(), heap.end(), ranks_before);
+				heap.pop_back();
+			}
+			heap.push_back(current_offer);
+			std::push_heap(heap.begin(), heap.end(), ranks_before);
+
+			//share the k-th best dropoff time with the other threads
+			if (objective::dropoff_time_is_cost && heap.size() == k)
+			{
+				double shared_dropoff_time = shared_kth_dropoff_time.load(std::memory_order_relaxed);
+				while (heap.front().dropoff_time < shared_dropoff_time && !shared_kth_dropoff_time.compare_exchange_weak(shared_dropoff_time, heap.front().dropoff_time, std::memory_order_relaxed))
+					;
+			}
+		}
+
+		dispatch_part_best_offer_calls[thread_index] = best_offer_calls;
+	});
+
+	//merge the heaps of all threads
+	offers.clear();
+	for (ULL thread_index = 0; thread_index < number_of_threads; ++thread_index)
+	{
+		total_best_offer_calls += dispatch_part_best_offer_calls[thread_index];
+		offers.insert(offers.end(), dispatch_part_offer_heaps[thread_index].begin(), dispatch_part_offer_heaps[thread_index].end());
+	}
+	std::sort(offers.begin(), offers.end(), ranks_before);
+	if (offers.size() > k)
+		offers.resize(k);
+}
+
+//simulate for all requests in the predetermined list
+//same as above but not using random events
+void ridesharing_sim::run_sim_request_list(std::list< std::pair< double, std::pair<ULL, ULL> > > request_list)
+{
+	double event_time;
+
+	//find time of last request
+	double max_time = 0;
+	next_request_time = 0;
+	if (!request_list.empty())
+	{
+		max_time = request_list.rbegin()->first;
+		next_request_time = request_list.begin()->first;
+	}
+
+	//transporters may have been changed since the last run
+	if (do_idle_index)
+		rebuild_idle_index();
+	if (do_admission_control)
+		rebuild_admission_state();
+	rebuild_fleet_load();
+	discard_speculative_offers();
+
+	//simulate until last request (does not finish serving all requests!)
+	while (time < max_time)
+	{
+		//with batch dispatch, collected requests are dispatched at the end of their window
+		double next_dispatch_time = next_request_time;
+		if (do_batch_dispatch && !pending_requests.empty())
+			next_dispatch_time = std::min(next_dispatch_time, next_batch_time);
+
+		if (do_timeseries_output &&
+			next_output_time < next_dispatch_time &&
+			(transporter_event_queue.empty() || next_output_time < transporter_event_queue.top().first) &&
+			(!do_measurement || next_output_time < next_measurement_time) &&
+			(!do_schedule_optimization || next_output_time < next_schedule_optimization_time) &&
+			(!do_reassignment || next_output_time < next_reassignment_time)
+			)
+		{
+			event_time = next_output_time;
+			output(event_time);
+
+			next_output_time += output_time_step;
+		}
+		//if the next event is a measurement event (and measurement is enabled)
+		else if (do_measurement &&
+			next_measurement_time < next_dispatch_time &&
+			(transporter_event_queue.empty() || next_measurement_time < transporter_event_queue.top().first) &&
+			(!do_schedule_optimization || next_measurement_time < next_schedule_optimization_time) &&
+			(!do_reassignment || next_measurement_time < next_reassignment_time)
+			)
+		{
+			event_time = next_measurement_time;
+			measurements.measure_system_status(transporter_list, event_time);
+
+			next_measurement_time += measurement_time_step;
+		}
+		//if the next event is the re-optimization of the schedules (and it is enabled)
+		else if (do_schedule_optimization &&
+			next_schedule_optimization_time < next_dispatch_time &&
+			(transporter_event_queue.empty() || next_schedule_optimization_time < transporter_event_queue.top().first) &&
+			(!do_reassignment || next_schedule_optimization_time < next_reassignment_time)
+			)
+		{
+			event_time = next_schedule_optimization_time;
+			optimize_schedules();
+
+			next_schedule_optimization_time += schedule_optimization_time_step;
+		}
+		//if the next event is the reassignment of customers that are not yet picked up (and it is enabled)
+		else if (do_reassignment &&
+			next_reassignment_time < next_dispatch_time &&
+			(transporter_event_queue.empty() || next_reassignment_time < transporter_event_queue.top().first)
+			)
+		{
+			event_time = next_reassignment_time;
+			reassign_customers(event_time);
+
+			next_reassignment_time += reassignment_time_step;
+		}
+		//if the next event is the dispatch of the collected requests
+		else if (next_dispatch_time < next_request_time &&
+			(transporter_event_queue.empty() || next_dispatch_time < transporter_event_queue.top().first)
+			)
+		{
+			event_time = next_batch_time;
+			dispatch_batch(event_time);
+		}
+		//if the next event is a new_request event
+		else if (transporter_event_queue.empty() || next_request_time < transporter_event_queue.top().first)
+		{
+			ULL request_origin;
+			ULL request_destination;
+
+			event_time = next_request_time;
+			request_origin = request_list.begin()->second.first;
+			request_destination = request_list.begin()->second.second;
+
+			//find the offers of the next requests in advance (once the previous ones are used)
+			if (do_speculative_dispatch && speculative_dispatch_applies() && next_speculative_request >= number_of_speculative_requests)
+			{
+				std::vector< std::pair< double, std::pair<ULL, ULL> > > requests(request_list.begin(), std::next(request_list.begin(), std::min(speculation_window, (ULL)request_list.size())));
+				speculate_requests(requests);
+			}
+
+			//dispatch the request and assign it to the transporter of the offer (or collect it for batch dispatch)
+			if (do_batch_dispatch)
+				collect_request(request_origin, request_destination, event_time);
+			else
+				handle_request(request_origin, request_destination, event_time);
+
+			//update event queue with the next request
+			//erase request from the request list
+			request_list.erase(request_list.begin());
+			if (!request_list.empty())
+				next_request_time = request_list.begin()->first;
+			else	//if no further request, set request time to a larger time (simulation stops here anyways)
+				next_request_time = event_time + std::numeric_limits<double>::max() / 2;
+
+		}
+		else {	//the next event is a bus event (bus arriving at a node along its route)
+
+			ULL event_transporter_index;
+			double next_transporter_event;
+
+			event_time = transporter_event_queue.top().first;
+			event_transporter_index = transporter_event_queue.top().second;
+			transporter_event_queue.pop();
+
+			//execute event and handle the next event of the transporter (if any)
+			next_transporter_event = transporter_list[event_transporter_index].execute_event(event_time, network, customers, measurements, total_serviced_requests, do_measurement);
+			mark_transporter_modified(event_transporter_index);
+
+			//update event queue with the next event of the transporter
+			update_idle_index(event_transporter_index);
+			update_admission_state(event_transporter_index);
+			update_fleet_load(event_transporter_index);
+			if (next_transporter_event >= event_time)
+				transporter_event_queue.push(std::make_pair(next_transporter_event, event_transporter_index));
+		}
+
+		time = event_time;
+	}
+
+	//if the simulation is continued with random requests, the next request happens immediately
+	next_request_time = time;
+	drop_used_upcoming_requests();
+}
+
+//random requests as in run_sim_requests (starting at the next request time), e.g. to replay the same requests with different dispatchers
+std::list< std::pair< double, std::pair<ULL, ULL> > > ridesharing_sim::generate_request_list(ULL number_of_requests)
+{
+	std::list< std::pair< double, std::pair<ULL, ULL> > > request_list;
+
+	double request_time = std::max(time, next_request_time);
+	for (ULL i = 0; i < number_of_requests; ++i)
+	{
+		request_list.push_back(std::make_pair(request_time, network.generate_request(request_random_generator)));
+		request_time += exp_dist(request_random_generator) / request_rate;
+	}
+
+	return(request_list);
+}
+
+//replay the same requests with each dispatcher, each starting from the current state of the simulation
+//measures the time needed to dispatch each request and the service of the customers (as in print_measurements)
+//the state of the simulation is restored afterwards
+std::vector< dispatcher_benchmark_result > ridesharing_sim::run_dispatcher_benchmark(std::list< std::pair< double, std::pair<ULL, ULL> > > request_list, std::vector< dispatcher* > dispatchers, double param_measurement_time_step)
+{
+	std::vector< dispatcher_benchmark_result > results;
+
+	//state of the simulation before the benchmark
+	std::vector<transporter> initial_transporter_list = transporter_list;
+	customer_pool initial_customers = customers;
+	transporter_event_queue_type initial_transporter_event_queue = transporter_event_queue;
+	double initial_time = time;
+	double initial_next_request_time = next_request_time;
+	ULL initial_total_requests = total_requests;
+	ULL initial_total_serviced_requests = total_serviced_requests;
+	ULL initial_total_best_offer_calls = total_best_offer_calls;
+	std::mt19937_64 initial_random_generator = random_generator;	//used for the choice between equally short routes
+	std::mt19937_64 initial_request_random_generator = request_random_generator;
+	std::vector< std::pair< double, std::pair<ULL, ULL> > > initial_pending_requests = pending_requests;
+	double initial_next_batch_time = next_batch_time;
+	double initial_next_schedule_optimization_time = next_schedule_optimization_time;
+	double initial_next_reassignment_time = next_reassignment_time;
+	std::vector< std::pair< double, std::pair<ULL, ULL> > > initial_upcoming_requests = upcoming_requests;
+	std::vector< double > initial_upcoming_request_intervals = upcoming_request_intervals;
+	ULL initial_next_upcoming_request = next_upcoming_request;
+	dispatcher* initial_dispatcher = request_dispatcher;
+	bool initial_do_measurement = do_measurement;
+	bool initial_do_timeseries_output = do_timeseries_output;
+
+	disable_timeseries_output();
+	for (dispatcher* d : dispatchers)
+	{
+		//start from the same state for every dispatcher
+		transporter_list = std::vector<transporter>(initial_transporter_list);
+		customers = initial_customers;
+		transporter_event_queue = initial_transporter_event_queue;
+		time = initial_time;
+		next_request_time = initial_next_request_time;
+		total_requests = initial_total_requests;
+		total_serviced_requests = initial_total_serviced_requests;
+		total_best_offer_calls = initial_total_best_offer_calls;
+		random_generator = initial_random_generator;
+		pending_requests = initial_pending_requests;
+		next_batch_time = initial_next_batch_time;
+		next_schedule_optimization_time = initial_next_schedule_optimization_time;
+		next_reassignment_time = initial_next_reassignment_time;
+
+		set_dispatcher(d);
+		enable_measurements(param_measurement_time_step);
+		enable_dispatch_timing();
+
+		run_sim_request_list(request_list);
+
+		disable_dispatch_timing();
+		disable_measurements();
+
+		//collect the results
+		dispatcher_benchmark_result r;
+		r.name = d->get_name();
+		r.requests = total_requests - start_of_measured_total_requests;
+		r.serviced_requests = total_serviced_requests - start_of_measured_serviced_requests;
+		r.best_offer_calls_per_request = (total_best_offer_calls - start_of_measured_best_offer_calls) / (double)r.requests;
+
+		std::sort(dispatch_latencies.begin(), dispatch_latencies.end());
+		r.mean_latency = 0;
+		for (double latency : dispatch_latencies)
+			r.mean_latency += latency;
+		if (!dispatch_latencies.empty())
+		{
+			r.mean_latency /= dispatch_latencies.size();
+			r.median_latency = dispatch_latencies[dispatch_latencies.size() / 2];
+			r.p99_latency = dispatch_latencies[std::min((ULL)(0.99 * dispatch_latencies.size()), (ULL)dispatch_latencies.size() - 1)];
+			r.max_latency = dispatch_latencies.back();
+		}
+		else
+			r.median_latency = r.p99_latency = r.max_latency = 0;
+
+		r.wait_time = measurements.get_wait_time();
+		r.drive_time = measurements.get_drive_time();
+		r.delay_time = measurements.get_delay_time();
+		r.fraction_of_delayed_trips = measurements.get_fraction_of_delayed_trips();
+
+		results.push_back(r);
+	}
+
+	//restore the state of the simulation
+	transporter_list = std::vector<transporter>(initial_transporter_list);
+	customers = initial_customers;
+	transporter_event_queue = initial_transporter_event_queue;
+	time = initial_time;
+	next_request_time = initial_next_request_time;
+	total_requests = initial_total_requests;
+	total_serviced_requests = initial_total_serviced_requests;
+	total_best_offer_calls = initial_total_best_offer_calls;
+	random_generator = initial_random_generator;
+	request_random_generator = initial_request_random_generator;
+	pending_requests = initial_pending_requests;
+	next_batch_time = initial_next_batch_time;
+	next_schedule_optimization_time = initial_next_schedule_optimization_time;
+	next_reassignment_time = initial_next_reassignment_time;
+	upcoming_requests = initial_upcoming_requests;
+	upcoming_request_intervals = initial_upcoming_request_intervals;
+	next_upcoming_request = initial_next_upcoming_request;
+	set_dispatcher(initial_dispatcher);
+	measurements.reset();
+	do_measurement = initial_do_measurement;
+	do_timeseries_output = initial_do_timeseries_output;
+	if (do_idle_index)
+		rebuild_idle_index();
+	if (do_admission_control)
+		rebuild_admission_state();
+	rebuild_fleet_load();
+
+	return(results);
+}
+
+//output the results of a benchmark, one column per dispatcher
+//latencies in microseconds, service measures as average (standard deviation)
+void ridesharing_sim::print_dispatcher_benchmark(std::vector< dispatcher_benchmark_result >& results, std::ofstream& out)
+{
+	out << "BENCHMARK" << std::endl << std::endl;
+
+	out << "dispatcher";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << r.name;
+	out << std::endl;
+
+	out << "requests";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << r.requests;
+	out << std::endl;
+	out << "serviced_requests";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << r.serviced_requests;
+	out << std::endl;
+	out << "best_offer calls per request";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << r.best_offer_calls_per_request;
+	out << std::endl;
+
+	out << "mean_latency [us]";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << 1e6 * r.mean_latency;
+	out << std::endl;
+	out << "median_latency [us]";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << 1e6 * r.median_latency;
+	out << std::endl;
+	out << "p99_latency [us]";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << 1e6 * r.p99_latency;
+	out << std::endl;
+	out << "max_latency [us]";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << 1e6 * r.max_latency;
+	out << std::endl;
+
+	out << "wait_time";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << r.wait_time.av << " (" << sqrt(r.wait_time.stddev / r.wait_time.n) << ")";
+	out << std::endl;
+	out << "drive_time";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << r.drive_time.av << " (" << sqrt(r.drive_time.stddev / r.drive_time.n) << ")";
+	out << std::endl;
+	out << "delay_time";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << r.delay_time.av << " (" << sqrt(r.delay_time.stddev / r.delay_time.n) << ")";
+	out << std::endl;
+	out << "fraction_of_delayed_trips";
+	for (dispatcher_benchmark_result& r : results)
+		out << '\t' << r.fraction_of_delayed_trips.av;
+	out << std::endl << std::endl;
+}
+
+//turn on batch dispatch: requests are collected for a time window (starting with the first collected request) and assigned jointly at its end
+//longer windows allow better joint assignments, but the customers wait longer before they are assigned
+//(batch dispatch always uses the insertion of transporter::best_offer with the objective of the simulation)
+void ridesharing_sim::enable_batch_dispatch(double param_batch_window, ULL param_batch_candidates)
+{
+	assert(param_batch_window >= 0 && param_batch_candidates > 0);
+	assert(!do_admission_control);
+
+	do_batch_dispatch = true;
+	batch_window = param_batch_window;
+	batch_candidates = param_batch_candidates;
+}
+
+//turn off batch dispatch (requests that are still collected are dispatched now)
+void ridesharing_sim::disable_batch_dispatch()
+{
+	if (!pending_requests.empty())
+		dispatch_batch(std::max(time, pending_requests.back().first));
+
+	do_batch_dispatch = false;
+}
+
+//collect a request for the next batch
+void ridesharing_sim::collect_request(ULL request_origin, ULL request_destination, double request_time)
+{
+	++total_requests;
+
+	if (pending_requests.empty())
+		next_batch_time = request_time + batch_window;
+	pending_requests.push_back(std::make_pair(request_time, std::make_pair(request_origin, request_destination)));
+}
+
+//dispatch all collected requests jointly
+void ridesharing_sim::dispatch_batch(double batch_time)
+{
+	switch (dispatch_objective)
+	{
+	case minimal_wait:
+		dispatch_batch_by_objective<minimal_wait_objective>(batch_time);
+		break;
+	case minimal_added_vehicle_time:
+		dispatch_batch_by_objective<minimal_added_vehicle_time_objective>(batch_time);
+		break;
+	case weighted_cost:
+		dispatch_batch_by_objective<default_weighted_cost_objective>(batch_time);
+		break;
+	default:
+		dispatch_batch_by_objective<earliest_dropoff_objective>(batch_time);
+		break;
+	}
+}
+
+//joint assignment of the collected requests in rounds:
+//	each request has a few candidate transporters with their best offer for the request (request-vehicle graph), chosen once per batch:
+//		the transporters with the best offers, found in order of the lower bounds of their dropoff time (as in the bound ordered search)
+//		(if the cost is not the dropoff time, the transporters with the smallest bounds)
+//	requests and transporters are matched with minimal total cost of the objective (at most one new customer per transporter and round, so all offers stay valid)
+//	unmatched requests are matched in the next round, only the offers of transporters that got a new customer are recomputed
+//requests of the same batch are not combined into trips first (no request-request shareability graph): two of them only share a transporter
+//if it gets them in different rounds, each inserted into the schedule as it is then
+template<class objective>
+void ridesharing_sim::dispatch_batch_by_objective(double batch_time)
+{
+	ULL number_of_requests = pending_requests.size();
+	ULL number_of_candidates = std::min(batch_candidates, (ULL)transporter_list.size());
+
+	//candidate transporters of each request and their offers (offers are computed from the batch time on)
+	batch_candidate_transporters.resize(number_of_requests * number_of_candidates);
+	batch_candidate_offers.resize(number_of_requests * number_of_candidates);
+	batch_candidate_rounds.assign(number_of_requests * number_of_candidates, 1);
+	batch_transporter_round.assign(transporter_list.size(), 0);
+
+	for (ULL r = 0; r < number_of_requests; ++r)
+	{
+		ULL request_origin = pending_requests[r].second.first;
+		ULL request_destination = pending_requests[r].second.second;
+
+		//transporters in a heap by bound (then index), only the transporters that are checked are taken from the heap
+		batch_bound_heap.resize(transporter_list.size());
+		for (ULL i = 0; i < transporter_list.size(); ++i)
+			batch_bound_heap[i] = std::make_pair(transporter_list[i].dropoff_time_bound(request_origin, request_destination, batch_time, network), i);
+		std::make_heap(batch_bound_heap.begin(), batch_bound_heap.end(), std::greater< std::pair<double, ULL> >());
+
+		//keep the best offers (the candidate with the worst offer first, as in a heap)
+		ULL first = r * number_of_candidates;
+		ULL number_of_offers = 0;
+		auto is_worse = [this, batch_time](ULL c1, ULL c2)
+		{
+			offer& o1 = batch_candidate_offers[c1];
+			offer& o2 = batch_candidate_offers[c2];
+			return(objective::cost(batch_time, o1.pickup_time, o1.dropoff_time, o1.added_vehicle_time) < objective::cost(batch_time, o2.pickup_time, o2.dropoff_time, o2.added_vehicle_time));
+		};
+		static thread_local std::vector<ULL> best_candidates;
+		best_candidates.clear();
+		while (!batch_bound_heap.empty())
+		{
+			double bound = batch_bound_heap.front().first;
+			ULL i = batch_bound_heap.front().second;
+			if (number_of_offers == number_of_candidates)
+			{
+				//no other transporter can make a better offer than the worst candidate
+				offer& worst = batch_candidate_offers[best_candidates.front()];
+				if (!objective::dropoff_time_is_cost || bound > worst.dropoff_time + MACRO_EPSILON)
+					break;
+			}
+			std::pop_heap(batch_bound_heap.begin(), batch_bound_heap.end(), std::greater< std::pair<double, ULL> >());
+			batch_bound_heap.pop_back();
+
+			offer no_offer;
+			offer o = transporter_list[i].best_offer<objective>(request_origin, request_destination, batch_time, network, no_offer);
+			++total_best_offer_calls;
+
+			ULL c;
+			if (number_of_offers < number_of_candidates)
+				c = first + number_of_offers++;
+			else {
+				//replace the worst candidate, if the new offer is better
+				if (objective::cost(batch_time, o.pickup_time, o.dropoff_time, o.added_vehicle_time) >= objective::cost(batch_time, batch_candidate_offers[best_candidates.front()].pickup_time, batch_candidate_offers[best_candidates.front()].dropoff_time, batch_candidate_offers[best_candidates.front()].added_vehicle_time))
+					continue;
+				std::pop_heap(best_candidates.begin(), best_candidates.end(), is_worse);
+				c = best_candidates.back();
+				best_candidates.pop_back();
+			}
+			batch_candidate_transporters[c] = i;
+			batch_candidate_offers[c] = o;
+			best_candidates.push_back(c);
+			std::push_heap(best_candidates.begin(), best_candidates.end(), is_worse);
+		}
+	}
+
+	std::vector<ULL> open_requests(number_of_requests);
+	for (ULL r = 0; r < number_of_requests; ++r)
+		open_requests[r] = r;
+
+	ULL round = 0;
+	while (!open_requests.empty())
+	{
+		++round;
+
+		//offers of all candidates (only recomputed if the transporter changed since the offer was made)
+		batch_assignment.reset(open_requests.size(), transporter_list.size());
+		for (ULL row = 0; row < open_requests.size(); ++row)
+		{
+			ULL r = open_requests[row];
+			for (ULL c = r * number_of_candidates; c < (r + 1) * number_of_candidates; ++c)
+			{
+				ULL i = batch_candidate_transporters[c];
+				if (batch_candidate_rounds[c] <= batch_transporter_round[i])
+				{
+					offer no_offer;
+					batch_candidate_offers[c] = transporter_list[i].best_offer<objective>(pending_requests[r].second.first, pending_requests[r].second.second, batch_time, network, no_offer);
+					batch_candidate_rounds[c] = round;
+					++total_best_offer_calls;
+				}
+
+				offer& o = batch_candidate_offers[c];
+				assert(o.best_transporter == &transporter_list[i]);
+				batch_assignment.add_edge(row, i, objective::cost(batch_time, o.pickup_time, o.dropoff_time, o.added_vehicle_time));
+			}
+		}
+
+		batch_assignment.solve();
+
+		//assign the matched requests (in the order of the requests), the others stay open
+		ULL number_of_open_requests = 0;
+		for (ULL row = 0; row < open_requests.size(); ++row)
+		{
+			ULL r = open_requests[row];
+			LL i = batch_assignment.get_assigned_column(row);
+			if (i < 0)
+			{
+				open_requests[number_of_open_requests++] = r;
+				continue;
+			}
+
+			for (ULL c = r * number_of_candidates; c < (r + 1) * number_of_candidates; ++c)
+			{
+				if (batch_candidate_transporters[c] == (ULL)i)
+				{
+					assign_request(pending_requests[r].second.first, pending_requests[r].second.second, pending_requests[r].first, batch_candidate_offers[c], batch_time);
+					batch_transporter_round[i] = round;
+					break;
+				}
+			}
+		}
+
+		//every round assigns at least one request
+		assert(number_of_open_requests < open_requests.size());
+		open_requests.resize(number_of_open_requests);
+	}
+
+	pending_requests.clear();
 }
@@ -21,14 +21,71 @@
 #include <fstream>
 #include <string>
 #include <functional>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <iterator>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #include "measurement_collector.h"
 #include "traffic_network.h"
 #include "customer.h"
 #include "transporter.h"
+#include "dispatch_objective.h"
+#include "dispatcher.h"
+#include "assignment_solver.h"
+#include "customer_pool.h"
+#include "worker_pool.h"
+#include "dispatch_statistics.h"
+#include "admission_policy.h"
 
 typedef std::priority_queue< std::pair<double, ULL>, std::vector<std::pair<double, ULL> >, std::greater< std::pair<double, ULL> > > transporter_event_queue_type;
 
+//results of one dispatcher in ridesharing_sim::run_dispatcher_benchmark (latencies in seconds)
+struct dispatcher_benchmark_result
+{
+	std::string name;
+
+	ULL requests;
+	ULL serviced_requests;
+	double best_offer_calls_per_request;
+
+	double mean_latency;
+	double median_latency;
+	double p99_latency;
+	double max_latency;
+
+	measure wait_time;
+	measure drive_time;
+	measure delay_time;
+	measure fraction_of_delayed_trips;
+};
+
+//upcoming request with its offer found in advance (see ridesharing_sim::speculate_requests)
+struct speculative_request
+{
+	double request_time;
+	ULL origin;
+	ULL destination;
+
+	offer speculative_offer;
+	std::vector<double> bounds;		//lower bound for the dropoff time of each transporter when the offer was found (max: no candidate)
+	ULL best_offer_calls;
+};
+
+//customer that is not yet picked up and the best transporter to move it to (see ridesharing_sim::reassign_customers)
+struct reassignment_move
+{
+	customer_handle c;
+	ULL from_transporter;
+
+	bool found;
+	offer new_offer;
+	double saving;			//vehicle time saved by the transporter giving up the customer - added vehicle time of the new transporter
+};
+
 class ridesharing_sim
 {
 public:
@@ -48,11 +105,176 @@ public:
 	void run_sim_time(long double max_time);
 
 	double execute_next_event();
+	void handle_request(ULL request_origin, ULL request_destination, double request_time);
+	void assign_request(ULL request_origin, ULL request_destination, double request_time, offer& o, double assignment_time);
+	offer find_best_offer(ULL request_origin, ULL request_destination, double request_time);
+	offer find_best_offer(ULL request_origin, ULL request_destination, double request_time, dispatch_objective_type objective);
+	template<class objective> offer find_best_offer_by_objective(ULL request_origin, ULL request_destination, double request_time);
+	template<class objective> offer find_best_offer_parallel(ULL request_origin, ULL request_destination, double request_time);
+	template<class objective> offer find_best_offer_by_bounds(ULL request_origin, ULL request_destination, double request_time, std::vector<double>& bounds, std::vector<ULL>& candidates,
+		std::vector<ULL>& visited, std::vector< std::vector<ULL> >& buckets, ULL& best_offer_calls);
+	template<class objective> offer find_best_offer_among_visited(ULL request_origin, ULL request_destination, double request_time, std::vector<double>& bounds, std::vector<ULL>& visited,
+		double best_dropoff_time, ULL& best_offer_calls);
+
+	//k best offers of different transporters for a request (e.g. for a customer choosing among them), best first, in one search over the transporters:
+	//each thread keeps a bounded heap of the best offers in its part of transporter_list (in order of the lower bounds for the dropoff time), the heaps are merged
+	//the chosen offer is assigned with assign_request, as long as its transporter has not changed since (see transporter::get_schedule_version)
+	void find_best_offers(ULL request_origin, ULL request_destination, double request_time, ULL k, std::vector<offer>& offers);
+	template<class objective> void find_best_offers_by_objective(ULL request_origin, ULL request_destination, double request_time, ULL k, std::vector<offer>& offers);
+
+	//approximate dispatch: check only the transporters with the smallest lower bounds for the dropoff time and only pickups before the first stops of each schedule
+	//a sampled fraction of the requests is also dispatched exactly (shadow evaluation) to measure how much worse the approximate offers are
+	void enable_approximate_dispatch(ULL param_max_transporters, ULL param_max_pickup_positions, double param_shadow_fraction);
+	void disable_approximate_dispatch();
+	void reset_shadow_statistics();
+	template<class objective> offer find_approximate_offer(ULL request_origin, ULL request_destination, double request_time);
+	bool do_approximate_dispatch;
+	ULL approximate_transporters;
+	ULL approximate_pickup_positions;
+	double shadow_fraction;
+	std::mt19937_64 shadow_random_generator;	//own generator, sampling does not change the simulation
+	ULL shadow_requests;						//requests that were also dispatched exactly
+	ULL shadow_different_offers;				//of these, requests with a different approximate offer
+	ULL shadow_compared_offers;					//of these, requests with an approximate and an exact offer (the loss is measured over these)
+	ULL shadow_missed_offers;					//of these, requests without an approximate offer but with an exact offer (admission control)
+	double shadow_total_cost_loss;				//cost of the approximate offer - cost of the exact offer (by the objective of the dispatch, see dispatch_objective.h)
+	double shadow_max_cost_loss;
+
+	//speculative dispatch: the offers of the next requests are found in advance on the dispatch threads and used in time order
+	//an offer is found again when the request happens if a transporter that could make an offer as good has changed since (event or new customer)
+	//same offers as dispatching each request when it happens, only used by find_best_offer with the earliest dropoff objective
+	//random requests are then drawn a window ahead from their own generator, so the simulation is the same for any window
+	void enable_speculative_dispatch(ULL param_window);
+	void disable_speculative_dispatch();
+	bool speculative_dispatch_applies();
+	void draw_upcoming_requests();
+	void speculate_requests(std::vector< std::pair< double, std::pair<ULL, ULL> > >& requests);
+	void find_speculative_offer(speculative_request& r);
+	bool take_speculative_offer(ULL request_origin, ULL request_destination, double request_time, offer& o);
+	void mark_transporter_modified(ULL transporter_index);
+	void discard_speculative_offers();
+	void drop_used_upcoming_requests();
+	bool do_speculative_dispatch;
+	ULL speculation_window;
+	std::vector< std::pair< double, std::pair<ULL, ULL> > > upcoming_requests;	//random requests drawn ahead (the times are only used to find their offers)
+	std::vector< double > upcoming_request_intervals;	//exponential draw for the time from each drawn request to the next (before dividing by the request rate)
+	ULL next_upcoming_request;
+	std::vector< speculative_request > speculative_requests;
+	ULL number_of_speculative_requests;
+	ULL next_speculative_request;
+	ULL speculation_round;								//incremented whenever offers are found in advance
+	std::vector< ULL > transporter_modified_round;		//last round in which each transporter changed
+	std::vector< ULL > modified_transporters;			//transporters changed in the current round
+	ULL speculative_hits;								//requests dispatched with the offer found in advance
+	ULL speculative_misses;								//requests dispatched again
+
+	//re-optimization of the schedules of the busy transporters in regular time steps (relocate, swap and 2-opt moves of their stops, see schedule_optimizer.h)
+	//snapshots of the schedules are optimized on the dispatch threads (which only read the snapshots), better orderings are committed before the next event
+	void enable_schedule_optimization(double param_time_step, ULL param_max_passes);
+	void disable_schedule_optimization();
+	void optimize_schedules();
+	bool do_schedule_optimization;
+	double schedule_optimization_time_step;
+	double next_schedule_optimization_time;
+	ULL schedule_optimization_max_passes;
+	std::vector< schedule_snapshot > schedule_snapshots;		//transporters with at least two stops
+	ULL number_of_schedule_snapshots;
+	std::vector< schedule_optimizer > schedule_optimizers;		//one per dispatch thread
+	ULL reordered_schedules;						//since the start of the measurements
+	double total_schedule_time_saved;				//earlier arrival at the last stop of the reordered schedules
+
+	//rolling-horizon reassignment in regular time steps: customers that are not yet picked up are moved to another transporter if that reduces the total vehicle time
+	//the other transporter must pick up and drop off the customer no later than promised (and not delay its other stops beyond their slack)
+	//moves are evaluated on the dispatch threads, then taken in order of their saving, at most one per transporter and time step
+	void enable_reassignment(double param_time_step);
+	void disable_reassignment();
+	void reassign_customers(double reassignment_time);
+	void evaluate_reassignment(reassignment_move& m, double reassignment_time);
+	bool do_reassignment;
+	double reassignment_time_step;
+	double next_reassignment_time;
+	std::vector< reassignment_move > reassignment_moves;
+	ULL number_of_reassignment_moves;
+	std::vector< ULL > reassignment_order;
+	std::vector< bool > transporter_reassigned;		//transporters changed in the current time step
+	ULL reassigned_customers;						//since the start of the measurements
+	double total_reassignment_time_saved;
+
+	//admission control for saturated systems (see admission_policy.h), only for requests that are dispatched at once (not in batches):
+	//	a request is rejected before the search if no transporter has room for two more stops (count kept up to date, see update_admission_state)
+	//	transporters that cannot pick up within the maximal wait or have no room make no offer (O(1) before their insertion search)
+	//	the offer found is rejected if its wait or detour exceeds the limits, rejected requests are counted by the measurements
+	void enable_admission_control(double param_max_wait, double param_max_detour_ratio, ULL param_max_planned_stops);
+	void disable_admission_control();
+	void rebuild_admission_state();
+	void update_admission_state(ULL transporter_index);
+	bool do_admission_control;
+	admission_policy admission;
+	std::vector< bool > transporter_has_room;
+	ULL transporters_with_room;
+
+	//load of the fleet for the dispatch statistics (only kept with DISPATCH_INSTRUMENTATION)
+	void rebuild_fleet_load();
+	void update_fleet_load(ULL transporter_index);
+	std::vector< ULL > transporter_planned_stops;
+	ULL number_of_busy_transporters;
+	ULL total_planned_stops;
+
+	//objective of the dispatcher, selected once per request (see dispatch_objective.h)
+	void set_dispatch_objective(dispatch_objective_type param_objective);
+	dispatch_objective_type dispatch_objective;
+
+	//keep a kinetic tree of the feasible orderings of the stops for every transporter, offers may then reorder the schedule (see kinetic_tree.h)
+	void enable_kinetic_trees(ULL param_max_orderings);
+	void disable_kinetic_trees();
+	ULL kinetic_tree_orderings;		//maximal number of orderings per transporter (0: disabled)
+
+	//types of the transporters (capacity, velocity, allowed delays, see fleet_type_table.h), only while no transporter has stops
+	//the fleet is stored grouped by type: transporters of the same type have consecutive indices, so that the dispatcher takes the same kernel for long runs of transporters
+	//(the request rate depends on the velocities, set it after changing the types)
+	void set_fleet_types(const fleet_type_table& param_fleet_types);
+	void set_fleet_composition(const std::vector<ULL>& param_transporters_per_type);
+	fleet_type_table fleet_types;
+	std::vector< ULL > fleet_type_begin;		//first transporter of each type (and the number of transporters at the end), empty if not grouped
+
+	//dispatcher of the requests (NULL: find_best_offer)
+	void set_dispatcher(dispatcher* param_dispatcher);
+	dispatcher* request_dispatcher;
+
+	//collect requests for a time window and assign them jointly (see dispatch_batch_by_objective)
+	void enable_batch_dispatch(double param_batch_window, ULL param_batch_candidates);
+	void disable_batch_dispatch();
+	void collect_request(ULL request_origin, ULL request_destination, double request_time);
+	void dispatch_batch(double batch_time);
+	template<class objective> void dispatch_batch_by_objective(double batch_time);
+	bool do_batch_dispatch;
+	double batch_window;
+	ULL batch_candidates;							//candidate transporters per request
+	double next_batch_time;
+	std::vector< std::pair< double, std::pair<ULL, ULL> > > pending_requests;
+	std::vector< ULL > batch_candidate_transporters;	//for each request: its candidates
+	std::vector< offer > batch_candidate_offers;
+	std::vector< ULL > batch_candidate_rounds;		//round in which the offer was made
+	std::vector< ULL > batch_transporter_round;		//last round in which the transporter got a new customer
+	std::vector< std::pair<double, ULL> > batch_bound_heap;	//transporters of the request that were not checked yet, by lower bound for the dropoff time
+	assignment_solver batch_assignment;
+
+	//time needed to dispatch each request (since timing was enabled)
+	void enable_dispatch_timing();
+	void disable_dispatch_timing();
+	bool do_dispatch_timing;
+	std::vector< double > dispatch_latencies;
+
+	//replay the same requests with several dispatchers and compare them
+	std::list< std::pair< double, std::pair<ULL, ULL> > > generate_request_list(ULL number_of_requests);
+	std::vector< dispatcher_benchmark_result > run_dispatcher_benchmark(std::list< std::pair< double, std::pair<ULL, ULL> > > request_list, std::vector< dispatcher* > dispatchers, double param_measurement_time_step);
+	void print_dispatcher_benchmark(std::vector< dispatcher_benchmark_result >& results, std::ofstream& out);
 
 	void print_params(std::ofstream& out, bool readable = false);
 
 	traffic_network network;
 	std::vector<transporter> transporter_list;
+	customer_pool customers;		//all customers that are not yet dropped off (and served customers, if retained)
 
 	double time;
 	ULL total_requests;
@@ -71,6 +293,71 @@ public:
 	double measurement_time_step;
 
 	measurement_collector measurements;
+	dispatch_statistics dispatch_work;		//work of the dispatcher per request, only measured with DISPATCH_INSTRUMENTATION (see dispatch_instrumentation.h)
+
+	//visit transporters in order of a lower bound on their dropoff time (stop if no better offer is possible)
+	void enable_bound_ordered_search();
+	void disable_bound_ordered_search();
+	bool do_bound_ordered_search;
+	std::vector< double > dispatch_bounds;				//lower bound for the dropoff time of each transporter
+	std::vector< std::vector<ULL> > dispatch_buckets;	//transporters sorted into buckets by their bound
+	std::vector< ULL > visited_transporters;
+	std::vector< ULL > dispatch_candidates;				//transporters to check for the current request
+	void collect_dispatch_candidates(ULL request_origin, ULL request_destination, double request_time);
+	void collect_dispatch_candidates(ULL request_origin, ULL request_destination, double request_time, std::vector<double>& bounds, std::vector<ULL>& candidates);
+	void collect_idle_dispatch_candidates(ULL request_origin, ULL request_destination, double request_time, std::vector<double>& bounds, std::vector<ULL>& candidates);
+	void add_idle_dispatch_candidates(ULL node, ULL request_origin, ULL request_destination, double request_time, double& best_idle_offer, std::vector<double>& bounds, std::vector<ULL>& candidates);
+
+	//check of the search: the offer of every request dispatched by find_best_offer is compared with the offer of checking all transporters in order
+	//(one thread, no bounds, no idle index), e.g. to check the bound ordered search with transporter types that allow delays, the simulation is not changed
+	void enable_dispatch_check();
+	void disable_dispatch_check();
+	void check_offer(ULL request_origin, ULL request_destination, double request_time, const offer& o);
+	template<class objective> offer find_best_offer_by_full_scan(ULL request_origin, ULL request_destination, double request_time);
+	bool do_dispatch_check;
+	ULL checked_requests;
+	ULL different_checked_offers;		//requests for which the offer differs from the full scan
+
+	//index of idle transporters by node (only one transporter per node needs to be checked), used by the bound ordered search
+	void enable_idle_index();
+	void disable_idle_index();
+	void rebuild_idle_index();
+	void update_idle_index(ULL transporter_index);
+	void insert_into_idle_index(ULL transporter_index);
+	void remove_from_idle_index(ULL transporter_index);
+	bool do_idle_index;
+	std::vector< std::vector<ULL> > idle_transporters_at_node;
+	std::vector< ULL > nodes_with_idle_transporters;
+	std::vector< ULL > node_index_position;			//position of each node in nodes_with_idle_transporters (-1 if none)
+	std::vector< ULL > busy_transporters;
+	std::vector< ULL > transporter_index_position;	//position of each transporter in its list (busy or idle at its node)
+	std::vector< ULL > transporter_indexed_node;	//node at which each transporter is indexed as idle (-1 if busy)
+	double max_velocity;
+
+	//idle transporters as structure of arrays (kept with the idle index), their offers are computed together for the search over all transporters
+	//(idle transporters have no occupancy, the tie breaking by occupancy uses the transporter)
+	void evaluate_idle_transporters(ULL request_origin, ULL request_destination, double request_time);
+	double min_idle_cost();
+	std::vector< ULL > idle_fleet_transporters;
+	std::vector< LL > idle_fleet_distance_rows;		//current location * number of nodes (row of the distance matrix)
+	std::vector< double > idle_fleet_times;
+	std::vector< double > idle_fleet_velocities;
+	std::vector< ULL > idle_fleet_position;			//position of each transporter in these arrays (-1 if busy)
+	std::vector< double > idle_pickup_times;		//offer of each idle transporter for the current request
+	std::vector< double > idle_dropoff_times;
+	std::vector< double > idle_added_vehicle_times;
+	std::vector< double > idle_costs;
+
+	//check parts of transporter_list on several threads (same offer as the sequential search)
+	void set_number_of_dispatch_threads(ULL param_number_of_threads);
+	worker_pool dispatch_workers;
+	std::vector< offer > dispatch_part_best_offers;		//best offer in the part of each thread
+	std::vector< ULL > dispatch_part_best_offer_calls;
+	std::vector< std::vector<offer> > dispatch_part_offer_heaps;						//k best offers in the part of each thread (see find_best_offers)
+	std::vector< std::vector< std::pair<double, ULL> > > dispatch_part_candidates;	//lower bound and index of the transporters in the part of each thread
+
+	ULL total_best_offer_calls;
+	ULL start_of_measured_best_offer_calls;
 
 	void enable_timeseries_output(double param_output_time_step, std::string output_filename); // bisher nicht aufgerufen
 	void disable_timeseries_output();
@@ -90,6 +377,7 @@ public:
 	double request_rate;
 
 	std::mt19937_64 random_generator;
+	std::mt19937_64 request_random_generator;	//own generator for the random requests (origin, destination and time)
 	std::exponential_distribution<double> exp_dist;
 };
 
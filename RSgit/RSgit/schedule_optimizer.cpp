@@ -0,0 +1,113 @@
+#include "schedule_optimizer.h"
+
+schedule_optimizer::schedule_optimizer()
+{
+	max_passes = 4;
+	current_end_time = 0;
+}
+
+schedule_optimizer::~schedule_optimizer()
+{
+	//dtor
+}
+
+//find a better ordering of the stops of the snapshot (result in the snapshot), true if the last stop is reached earlier
+bool schedule_optimizer::optimize(schedule_snapshot& s, traffic_network& n)
+{
+	ULL number_of_stops = s.stop_nodes.size();
+	current.resize(number_of_stops);
+	for (ULL k = 0; k < number_of_stops; ++k)
+		current[k] = k;
+	current_end_time = end_time(s, current, n, std::numeric_limits<double>::infinity());
+	s.current_end_time = current_end_time;
+
+	bool improved = (number_of_stops > 1 && current_end_time < std::numeric_limits<double>::infinity());
+	for (ULL pass = 0; improved && pass < max_passes; ++pass)
+	{
+		improved = false;
+
+		//relocate: move the stop at position i to position j
+		for (ULL i = 0; i < number_of_stops; ++i)
+		{
+			for (ULL j = 0; j < number_of_stops; ++j)
+			{
+				if (j == i)
+					continue;
+				candidate = current;
+				if (i < j)
+					std::rotate(candidate.begin() + i, candidate.begin() + i + 1, candidate.begin() + j + 1);
+				else
+					std::rotate(candidate.begin() + j, candidate.begin() + i, candidate.begin() + i + 1);
+				improved |= try_candidate(s, n);
+			}
+		}
+
+		//swap the stops at positions i and j (neighbouring stops are already swapped by relocate)
+		for (ULL i = 0; i < number_of_stops; ++i)
+		{
+			for (ULL j = i + 2; j < number_of_stops; ++j)
+			{
+				candidate = current;
+				std::swap(candidate[i], candidate[j]);
+				improved |= try_candidate(s, n);
+			}
+		}
+
+		//2-opt: reverse the stops at positions i to j (three stops are already reversed by swap)
+		for (ULL i = 0; i < number_of_stops; ++i)
+		{
+			for (ULL j = i + 3; j < number_of_stops; ++j)
+			{
+				candidate = current;
+				std::reverse(candidate.begin() + i, candidate.begin() + j + 1);
+				improved |= try_candidate(s, n);
+			}
+		}
+	}
+
+	s.ordering = current;
+	s.end_time = current_end_time;
+	s.improved = (current_end_time < s.current_end_time - MACRO_EPSILON);
+	return(s.improved);
+}
+
+//take the candidate ordering if it reaches the last stop earlier than the current ordering
+bool schedule_optimizer::try_candidate(const schedule_snapshot& s, traffic_network& n)
+{
+	double candidate_end_time = end_time(s, candidate, n, current_end_time - MACRO_EPSILON);
+	if (candidate_end_time >= current_end_time - MACRO_EPSILON)
+		return(false);
+
+	current.swap(candidate);
+	current_end_time = candidate_end_time;
+	return(true);
+}
+
+//arrival at the last stop when driving along the ordering (accumulated in the same order as transporter::update_schedule)
+//infinity if a dropoff comes before its pickup, the capacity is exceeded, a stop arrives after its deadline or the limit is exceeded
+double schedule_optimizer::end_time(const schedule_snapshot& s, const std::vector<ULL>& ordering, traffic_network& n, double limit)
+{
+	stop_visited.assign(ordering.size(), false);
+
+	double temp_time = s.time;
+	ULL temp_location = s.location;
+	LL temp_occupancy = s.occupancy;
+	for (ULL k : ordering)
+	{
+		if (s.pickup_of_stop[k] != (ULL)-1 && !stop_visited[s.pickup_of_stop[k]])
+			return(std::numeric_limits<double>::infinity());
+
+		temp_time += n.get_network_distance(temp_location, s.stop_nodes[k]) / s.velocity;
+		temp_location = s.stop_nodes[k];
+		if (temp_time > s.deadlines[k] || temp_time > limit)
+			return(std::numeric_limits<double>::infinity());
+
+		temp_occupancy += s.occupancy_changes[k];
+		if (s.capacity >= 0 && temp_occupancy > s.capacity)
+			return(std::numeric_limits<double>::infinity());
+
+		stop_visited[k] = true;
+	}
+
+	return(temp_time);
+}
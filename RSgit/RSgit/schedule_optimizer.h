@@ -0,0 +1,77 @@
+#ifndef SCHEDULE_OPTIMIZER_H
+#define SCHEDULE_OPTIMIZER_H
+
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include <cassert>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+#ifndef _EPSILON
+#define MACRO_EPSILON 0.000000000001
+#define _EPSILON
+#endif
+
+#include "traffic_network.h"
+
+//copy of the assigned stops of a transporter and of its state, the optimizer only works on this copy (see transporter::get_schedule_snapshot)
+struct schedule_snapshot
+{
+	ULL transporter_index;
+
+	ULL location;
+	double time;
+	double velocity;
+	LL occupancy;
+	LL capacity;
+
+	//per stop, in the order of the current schedule
+	std::vector<uint32_t> stop_nodes;
+	std::vector<LL> occupancy_changes;
+	std::vector<double> deadlines;		//latest arrival at the stop that does not exceed the allowed delay (at least the planned arrival)
+	std::vector<ULL> pickup_of_stop;	//for a dropoff whose pickup is also in the schedule: position of the pickup (otherwise -1)
+
+	//result: better ordering of the stops (positions in the current schedule) and when it reaches its last stop
+	bool improved;
+	std::vector<ULL> ordering;
+	double end_time;
+	double current_end_time;
+};
+
+//local search over the orderings of the stops of one transporter
+//moves: relocate one stop, swap two stops, reverse a part of the schedule (2-opt)
+//a move is taken if the ordering stays feasible (order of pickup and dropoff, capacity, deadlines) and reaches the last stop earlier (by more than epsilon)
+//repeated until no move improves the ordering or the maximal number of passes is reached
+class schedule_optimizer
+{
+public:
+	schedule_optimizer();
+	virtual ~schedule_optimizer();
+
+	void set_max_passes(ULL param_max_passes) { max_passes = std::max((ULL)1, param_max_passes); }
+
+	bool optimize(schedule_snapshot& s, traffic_network& n);
+
+protected:
+
+private:
+	double end_time(const schedule_snapshot& s, const std::vector<ULL>& ordering, traffic_network& n, double limit);	//infinity if the ordering is not feasible or ends after the limit
+	bool try_candidate(const schedule_snapshot& s, traffic_network& n);
+
+	ULL max_passes;
+
+	//reused buffers
+	std::vector<ULL> current;
+	std::vector<ULL> candidate;
+	double current_end_time;
+	std::vector<bool> stop_visited;
+};
+
+#endif // SCHEDULE_OPTIMIZER_H
@@ -1,5 +1,6 @@
 #include "traffic_network.h"
 #include <functional>
+#include <algorithm>
 
 traffic_network::traffic_network(ULL param_N, std::mt19937_64 &param_random_generator) : random_generator(param_random_generator)
 {
@@ -19,12 +20,25 @@ void traffic_network::init(ULL param_N, std::mt19937_64 &param_random_generator,
 
 	potential_route_nodes.reserve(number_of_nodes);
 
-	network_distances.resize(number_of_nodes);
+	network_distances.assign(number_of_nodes * number_of_nodes, 1e10);
+
+	//neighbour rings are disabled by default
+	use_neighbour_rings = false;
+	neighbour_ring_radius = 0;
+	max_neighbour_ring_size = 0;
+
+	//no nodes contracted yet
+	original_node_index.resize(number_of_nodes);
+	contracted_node_index.resize(number_of_nodes);
 	for (ULL i = 0; i < number_of_nodes; ++i)
 	{
-		network_distances[i] = std::vector<double>(number_of_nodes, 1e10);
+		original_node_index[i] = i;
+		contracted_node_index[i] = i;
 	}
 
+	//all nodes are in a single zone by default
+	set_zones(std::vector<ULL>(number_of_nodes, 0), 1);
+
 	//add all links in the list
 	for (auto& e : param_links)
 		add_link(std::get<0>(e), std::get<1>(e), std::get<2>(e));
@@ -45,12 +59,21 @@ traffic_network::~traffic_network()
 	origin_probabilities.clear();
 	destination_probabilities.clear();
 
-	for (ULL i = 0; i < number_of_nodes; ++i)
-	{
-		network_distances[i].clear();
-	}
 	network_distances.clear();
 
+	neighbour_ring_entries.clear();
+	neighbour_ring_start.clear();
+	neighbour_ring_length.clear();
+	neighbour_ring_reach.clear();
+
+	original_node_index.clear();
+	contracted_node_index.clear();
+
+	zone_of_node.clear();
+	zone_nodes.clear();
+	min_zone_distances.clear();
+	max_zone_distances.clear();
+
 	for (auto& e : edgelist)
 		e.second.clear();
 	edgelist.clear();
@@ -67,15 +90,146 @@ void traffic_network::add_link(ULL from, ULL to, double dist)
 	edgelist[from].insert(std::make_pair(to, dist));
 }
 
+//remove shape nodes (never origin or destination of a request) that only connect two other nodes
+//each path through a removed node is replaced by a single link with the summed length
+ULL traffic_network::contract_shape_nodes()
+{
+	//outgoing and incoming links of all nodes (shortest link if there are several between two nodes)
+	std::vector< std::map<ULL, double> > outgoing(number_of_nodes);
+	std::vector< std::map<ULL, double> > incoming(number_of_nodes);
+	for (auto& links : edgelist)
+	{
+		for (auto& e : links.second)
+		{
+			auto it = outgoing[links.first].find(e.first);
+			if (it == outgoing[links.first].end() || e.second < it->second)
+			{
+				outgoing[links.first][e.first] = e.second;
+				incoming[e.first][links.first] = e.second;
+			}
+		}
+	}
+
+	std::vector<bool> removed(number_of_nodes, false);
+	std::deque<ULL> candidates;
+	for (ULL v = 0; v < number_of_nodes; ++v)
+		candidates.push_back(v);
+
+	std::set<ULL> neighbours;
+	ULL number_of_removed_nodes = 0;
+	while (!candidates.empty())
+	{
+		ULL v = candidates.front();
+		candidates.pop_front();
+
+		//only shape nodes can be removed
+		if (removed[v] || origin_probabilities[v] > 0 || destination_probabilities[v] > 0 || outgoing[v].count(v) > 0)
+			continue;
+
+		neighbours.clear();
+		for (auto& e : outgoing[v])
+			neighbours.insert(e.first);
+		for (auto& e : incoming[v])
+			neighbours.insert(e.first);
+		if (neighbours.size() != 2)
+			continue;
+
+		//a shortest path only passes through v from one neighbour to the other (never back to the same neighbour)
+		bool has_through_path = false;
+		for (auto& in : incoming[v])
+			for (auto& out : outgoing[v])
+				if (in.first != out.first)
+					has_through_path = true;
+		if (!has_through_path)
+			continue;
+
+		//replace each path x -> v -> y by a single link x -> y (unless there already is a shorter one)
+		for (auto& in : incoming[v])
+		{
+			for (auto& out : outgoing[v])
+			{
+				ULL x = in.first;
+				ULL y = out.first;
+				if (x == y)
+					continue;
+
+				double dist = in.second + out.second;
+				auto it = outgoing[x].find(y);
+				if (it != outgoing[x].end() && it->second <= dist)
+					continue;
+
+				outgoing[x][y] = dist;
+				incoming[y][x] = dist;
+			}
+		}
+
+		//remove v and all its links
+		for (auto& in : incoming[v])
+			outgoing[in.first].erase(v);
+		for (auto& out : outgoing[v])
+			incoming[out.first].erase(v);
+		outgoing[v].clear();
+		incoming[v].clear();
+		removed[v] = true;
+		++number_of_removed_nodes;
+
+		//the neighbours may have become part of a chain now
+		for (ULL u : neighbours)
+			candidates.push_back(u);
+	}
+
+	if (number_of_removed_nodes == 0)
+		return(0);
+
+	//renumber the remaining nodes (keeping their order)
+	std::vector<ULL> new_index(number_of_nodes, -1);
+	std::vector<ULL> new_original_node_index;
+	std::vector<double> new_origin_probabilities;
+	std::vector<double> new_destination_probabilities;
+	for (ULL v = 0; v < number_of_nodes; ++v)
+	{
+		if (!removed[v])
+		{
+			new_index[v] = new_original_node_index.size();
+			new_original_node_index.push_back(original_node_index[v]);
+			new_origin_probabilities.push_back(origin_probabilities[v]);
+			new_destination_probabilities.push_back(destination_probabilities[v]);
+		}
+	}
+
+	edgelist.clear();
+	for (ULL v = 0; v < number_of_nodes; ++v)
+		for (auto& out : outgoing[v])
+			edgelist[new_index[v]].insert(std::make_pair(new_index[out.first], out.second));
+
+	for (ULL& i : contracted_node_index)
+		if (i != (ULL)-1)
+			i = new_index[i];
+	original_node_index = new_original_node_index;
+
+	//resize all node based data structures
+	number_of_nodes = original_node_index.size();
+	potential_route_nodes.reserve(number_of_nodes);
+
+	network_distances.assign(number_of_nodes * number_of_nodes, 1e10);
+
+	origin_probabilities = new_origin_probabilities;
+	random_origin = std::discrete_distribution<ULL>(origin_probabilities.begin(), origin_probabilities.end());
+	destination_probabilities = new_destination_probabilities;
+	random_destination = std::discrete_distribution<ULL>(destination_probabilities.begin(), destination_probabilities.end());
+
+	reset_neighbour_rings();
+	set_zones(std::vector<ULL>(number_of_nodes, 0), 1);
+	recalc_mean_distances();
+
+	return(number_of_removed_nodes);
+}
+
 //calculate all shortest path distances by breadth first search (direct implementation of Dijkstra)
 void traffic_network::create_distances()
 {
 	//reset the shape for the distance matrix, with 1e10 distances between all nodes (no distances found yet)
-	network_distances.resize(number_of_nodes);
-	for (ULL i = 0; i < number_of_nodes; ++i)
-	{
-		network_distances[i] = std::vector<double>(number_of_nodes, 1e10);
-	}
+	network_distances.assign(number_of_nodes * number_of_nodes, 1e10);
 
 	//then fill the distance matrix by finding all shortest paths (works for positive weighted graphs)
 	std::priority_queue< std::pair<double, ULL>, std::vector< std::pair<double, ULL> >, std::greater< std::pair<double, ULL> > > next;
@@ -83,27 +237,31 @@ void traffic_network::create_distances()
 
 	for (ULL i = 0; i < number_of_nodes; ++i)
 	{
-		network_distances[i][i] = 0;
-		next.push(std::make_pair(network_distances[i][i], i));
+		network_distances[i * number_of_nodes + i] = 0;
+		next.push(std::make_pair(network_distances[i * number_of_nodes + i], i));
 
 		while (!next.empty())
 		{
 			current = next.top();
 			next.pop();
 
-			if (network_distances[i][current.second] == current.first)
+			if (network_distances[i * number_of_nodes + current.second] == current.first)
 			{
 				for (std::pair<ULL, double> e : edgelist[current.second])
 				{
-					if (network_distances[i][e.first] > network_distances[i][current.second] + e.second)
+					if (network_distances[i * number_of_nodes + e.first] > network_distances[i * number_of_nodes + current.second] + e.second)
 					{
-						network_distances[i][e.first] = network_distances[i][current.second] + e.second;
-						next.push(std::make_pair(network_distances[i][e.first], e.first));
+						network_distances[i * number_of_nodes + e.first] = network_distances[i * number_of_nodes + current.second] + e.second;
+						next.push(std::make_pair(network_distances[i * number_of_nodes + e.first], e.first));
 					}
 				}
 			}
 		}
 	}
+
+	//distances changed, previously generated rings and zone distances are outdated
+	reset_neighbour_rings();
+	calc_zone_distances();
 }
 
 //set origin probabilities to default: uniform distribution
@@ -176,16 +334,22 @@ void traffic_network::recalc_mean_distances()
 //return distance in the network
 double traffic_network::get_network_distance(ULL from, ULL to)
 {
-	return(network_distances[from][to]);
+	return(network_distances[from * number_of_nodes + to]);
 }
 
 //generate a new request based on the (uncorrelated) origin and destination probabilities
 std::pair< ULL, ULL > traffic_network::generate_request()
+{
+	return(generate_request(random_generator));
+}
+
+//same as above, drawn from the given generator
+std::pair< ULL, ULL > traffic_network::generate_request(std::mt19937_64& generator)
 {
 	std::pair<ULL, ULL> request;
 
-	request.first = random_origin(random_generator);
-	request.second = random_destination(random_generator);
+	request.first = random_origin(generator);
+	request.second = random_destination(generator);
 
 	return(request);
 }
@@ -235,3 +399,430 @@ std::deque< std::pair<ULL, double> > traffic_network::find_shortest_path(ULL fro
 
 	return(route);
 }
+
+
+//turn on neighbour rings with a maximum radius and a maximum number of nodes per ring
+void traffic_network::enable_neighbour_rings(double param_radius, ULL param_max_ring_size)
+{
+	assert(param_radius >= 0);
+	assert(param_max_ring_size > 0);
+
+	use_neighbour_rings = true;
+	neighbour_ring_radius = param_radius;
+	max_neighbour_ring_size = std::min(param_max_ring_size, number_of_nodes);
+
+	reset_neighbour_rings();
+}
+
+//turn off neighbour rings and free their memory
+void traffic_network::disable_neighbour_rings()
+{
+	use_neighbour_rings = false;
+
+	reset_neighbour_rings();
+}
+
+//forget all generated rings (they are regenerated on demand)
+void traffic_network::reset_neighbour_rings()
+{
+	neighbour_ring_entries.clear();
+	neighbour_ring_entries.shrink_to_fit();
+
+	if (use_neighbour_rings)
+	{
+		neighbour_ring_start.assign(number_of_nodes, (ULL)-1);
+		neighbour_ring_length.assign(number_of_nodes, 0);
+		neighbour_ring_reach.assign(number_of_nodes, 0);
+	}
+	else
+	{
+		neighbour_ring_start.clear();
+		neighbour_ring_length.clear();
+		neighbour_ring_reach.clear();
+	}
+}
+
+//return the ring of nodes around a node, sorted by increasing distance to the node (generate if necessary)
+neighbour_ring traffic_network::get_neighbour_ring(ULL node)
+{
+	assert(use_neighbour_rings);
+	assert(node < number_of_nodes);
+
+	if (neighbour_ring_start[node] == (ULL)-1)
+		generate_neighbour_ring(node);
+
+	const ring_entry* first = neighbour_ring_entries.data() + neighbour_ring_start[node];
+	return(neighbour_ring(first, first + neighbour_ring_length[node], neighbour_ring_reach[node]));
+}
+
+//generate the rings of all nodes that were not generated yet
+void traffic_network::generate_all_neighbour_rings()
+{
+	assert(use_neighbour_rings);
+
+	for (ULL node = 0; node < number_of_nodes; ++node)
+	{
+		if (neighbour_ring_start[node] == (ULL)-1)
+			generate_neighbour_ring(node);
+	}
+}
+
+//collect all nodes within the ring radius, keep the nearest ones and append them to the ring storage
+void traffic_network::generate_neighbour_ring(ULL node)
+{
+	std::vector< ring_entry > candidates;
+	candidates.reserve(number_of_nodes);
+
+	//distances TO the center of the ring (column of the distance matrix)
+	for (ULL j = 0; j < number_of_nodes; ++j)
+	{
+		if (network_distances[j * number_of_nodes + node] <= neighbour_ring_radius)
+			candidates.push_back(ring_entry(j, network_distances[j * number_of_nodes + node]));
+	}
+
+	auto closer = [](const ring_entry& a, const ring_entry& b) { return(a.distance < b.distance || (a.distance == b.distance && a.node_index < b.node_index)); };
+
+	//nodes outside the radius are further away than the radius
+	double reach = neighbour_ring_radius;
+	if (candidates.size() > max_neighbour_ring_size)
+	{
+		//only keep the nearest nodes, all others are at least as far away as the last node kept
+		std::partial_sort(candidates.begin(), candidates.begin() + max_neighbour_ring_size, candidates.end(), closer);
+		candidates.erase(candidates.begin() + max_neighbour_ring_size, candidates.end());
+		reach = candidates.back().distance;
+	}
+	else
+	{
+		std::sort(candidates.begin(), candidates.end(), closer);
+	}
+
+	neighbour_ring_start[node] = neighbour_ring_entries.size();
+	neighbour_ring_length[node] = candidates.size();
+	neighbour_ring_reach[node] = reach;
+	neighbour_ring_entries.insert(neighbour_ring_entries.end(), candidates.begin(), candidates.end());
+}
+
+
+//one level of the multilevel zone partitioning: undirected graph with node and link weights
+struct zone_graph
+{
+	std::vector< std::vector< std::pair<ULL, double> > > adjacency;	//neighbours and link weights (symmetric)
+	std::vector< double > node_weights;
+	std::vector< ULL > coarse_node;		//node of the next coarser level that each node is merged into
+};
+
+//merge pairs of neighbouring nodes along heavy links (heavy edge matching), return the coarser graph
+static zone_graph coarsen_zone_graph(zone_graph& fine, std::mt19937_64& generator)
+{
+	ULL n = fine.node_weights.size();
+	ULL unmatched = n;
+
+	//visit nodes in random order, match each with its unmatched neighbour connected by the heaviest link
+	std::vector<ULL> order(n);
+	for (ULL i = 0; i < n; ++i)
+		order[i] = i;
+	std::shuffle(order.begin(), order.end(), generator);
+
+	std::vector<ULL> match(n, unmatched);
+	for (ULL v : order)
+	{
+		if (match[v] != unmatched)
+			continue;
+
+		ULL best_neighbour = v;
+		double best_weight = -1;
+		for (auto& e : fine.adjacency[v])
+		{
+			if (match[e.first] == unmatched && e.first != v && e.second > best_weight)
+			{
+				best_neighbour = e.first;
+				best_weight = e.second;
+			}
+		}
+		match[v] = best_neighbour;
+		match[best_neighbour] = v;
+	}
+
+	//number the coarse nodes
+	ULL number_of_coarse_nodes = 0;
+	fine.coarse_node.assign(n, unmatched);
+	for (ULL v = 0; v < n; ++v)
+	{
+		if (fine.coarse_node[v] == unmatched)
+		{
+			fine.coarse_node[v] = number_of_coarse_nodes;
+			fine.coarse_node[match[v]] = number_of_coarse_nodes;
+			++number_of_coarse_nodes;
+		}
+	}
+
+	//sum up node weights and link weights (links inside a coarse node disappear)
+	zone_graph coarse;
+	coarse.node_weights.assign(number_of_coarse_nodes, 0);
+	coarse.adjacency.resize(number_of_coarse_nodes);
+
+	std::vector<double> link_weight(number_of_coarse_nodes, 0);
+	std::vector<ULL> linked_nodes;
+	for (ULL v = 0; v < n; ++v)
+	{
+		//handle each coarse node once (from its first fine node)
+		if (match[v] < v)
+			continue;
+
+		ULL c = fine.coarse_node[v];
+
+		linked_nodes.clear();
+		for (ULL u : { v, match[v] })
+		{
+			coarse.node_weights[c] += fine.node_weights[u];
+			for (auto& e : fine.adjacency[u])
+			{
+				ULL c_neighbour = fine.coarse_node[e.first];
+				if (c_neighbour == c)
+					continue;
+				if (link_weight[c_neighbour] == 0)
+					linked_nodes.push_back(c_neighbour);
+				link_weight[c_neighbour] += e.second;
+			}
+			if (match[v] == v)
+				break;
+		}
+
+		for (ULL c_neighbour : linked_nodes)
+		{
+			coarse.adjacency[c].push_back(std::make_pair(c_neighbour, link_weight[c_neighbour]));
+			link_weight[c_neighbour] = 0;
+		}
+	}
+
+	return(coarse);
+}
+
+//initial partition of the coarsest graph: grow one zone after the other from a seed node by adding the most strongly connected neighbours
+static std::vector<ULL> grow_zones(zone_graph& g, ULL param_number_of_zones)
+{
+	ULL n = g.node_weights.size();
+	ULL unassigned = param_number_of_zones;
+	std::vector<ULL> zone(n, unassigned);
+
+	double total_weight = 0;
+	for (double w : g.node_weights)
+		total_weight += w;
+
+	double assigned_weight = 0;
+	std::vector<double> connection(n, 0);
+	for (ULL k = 0; k + 1 < param_number_of_zones; ++k)
+	{
+		//target weight of the remaining zones
+		double target_weight = (total_weight - assigned_weight) / (param_number_of_zones - k);
+		double zone_weight = 0;
+		std::fill(connection.begin(), connection.end(), 0);
+
+		while (zone_weight < target_weight)
+		{
+			//pick the unassigned node most strongly connected to the zone (or the first unassigned node to start a zone)
+			ULL next = n;
+			double best_connection = -1;
+			for (ULL v = 0; v < n; ++v)
+			{
+				if (zone[v] == unassigned && connection[v] > best_connection)
+				{
+					next = v;
+					best_connection = connection[v];
+				}
+			}
+			if (next == n)
+				break;
+
+			//do not overshoot the target by more than half a node if the zone already has nodes
+			if (zone_weight > 0 && zone_weight + g.node_weights[next] - target_weight > target_weight - zone_weight)
+				break;
+
+			zone[next] = k;
+			zone_weight += g.node_weights[next];
+			for (auto& e : g.adjacency[next])
+				connection[e.first] += e.second;
+		}
+		assigned_weight += zone_weight;
+	}
+
+	//the last zone takes all remaining nodes
+	for (ULL v = 0; v < n; ++v)
+		if (zone[v] == unassigned)
+			zone[v] = param_number_of_zones - 1;
+
+	return(zone);
+}
+
+//improve a partition by moving boundary nodes to neighbouring zones (reduce cut link weight, keep zones balanced)
+static void refine_zones(zone_graph& g, std::vector<ULL>& zone, ULL param_number_of_zones)
+{
+	ULL n = g.node_weights.size();
+
+	double total_weight = 0;
+	double max_node_weight = 0;
+	std::vector<double> zone_weights(param_number_of_zones, 0);
+	for (ULL v = 0; v < n; ++v)
+	{
+		total_weight += g.node_weights[v];
+		max_node_weight = std::max(max_node_weight, g.node_weights[v]);
+		zone_weights[zone[v]] += g.node_weights[v];
+	}
+	double max_zone_weight = 1.03 * total_weight / param_number_of_zones + max_node_weight;
+
+	std::vector<double> connection(param_number_of_zones, 0);
+	std::vector<ULL> linked_zones;
+	bool moved = true;
+	for (ULL pass = 0; pass < 10 && moved; ++pass)
+	{
+		moved = false;
+		for (ULL v = 0; v < n; ++v)
+		{
+			ULL own_zone = zone[v];
+			double w = g.node_weights[v];
+
+			//never empty a zone
+			if (zone_weights[own_zone] <= w)
+				continue;
+
+			//connection of the node to all neighbouring zones
+			linked_zones.clear();
+			for (auto& e : g.adjacency[v])
+			{
+				if (connection[zone[e.first]] == 0)
+					linked_zones.push_back(zone[e.first]);
+				connection[zone[e.first]] += e.second;
+			}
+
+			//find the best zone to move to (largest reduction of cut link weight)
+			//if the own zone is overloaded, also accept moves that increase the cut
+			bool overloaded = zone_weights[own_zone] > max_zone_weight;
+			ULL best_zone = own_zone;
+			double best_gain = 0;
+			for (ULL z : linked_zones)
+			{
+				if (z == own_zone || zone_weights[z] + w > max_zone_weight)
+					continue;
+
+				double gain = connection[z] - connection[own_zone];
+				if ((best_zone == own_zone && (gain > 0 || overloaded || (gain == 0 && zone_weights[z] + w < zone_weights[own_zone]))) ||
+					(best_zone != own_zone && (gain > best_gain || (gain == best_gain && zone_weights[z] < zone_weights[best_zone]))))
+				{
+					best_zone = z;
+					best_gain = gain;
+				}
+			}
+
+			for (ULL z : linked_zones)
+				connection[z] = 0;
+
+			if (best_zone != own_zone)
+			{
+				zone[v] = best_zone;
+				zone_weights[own_zone] -= w;
+				zone_weights[best_zone] += w;
+				moved = true;
+			}
+		}
+	}
+}
+
+//partition the network into zones of (approximately) equal number of nodes with few links between zones
+void traffic_network::create_zones(ULL param_number_of_zones)
+{
+	assert(param_number_of_zones > 0);
+	assert(param_number_of_zones <= number_of_nodes);
+
+	//use a separate random generator, so the partitioning does not change the random numbers of the simulation
+	std::mt19937_64 zone_generator(param_number_of_zones);
+
+	//undirected version of the network (link weight = number of directed links between two nodes)
+	std::vector<zone_graph> levels(1);
+	levels[0].node_weights.assign(number_of_nodes, 1);
+	levels[0].adjacency.resize(number_of_nodes);
+	for (auto& links : edgelist)
+	{
+		for (auto& e : links.second)
+		{
+			if (e.first == links.first)
+				continue;
+			for (ULL u : { links.first, e.first })
+			{
+				ULL v = (u == links.first) ? e.first : links.first;
+				auto it = std::find_if(levels[0].adjacency[u].begin(), levels[0].adjacency[u].end(), [v](const std::pair<ULL, double>& a) { return(a.first == v); });
+				if (it == levels[0].adjacency[u].end())
+					levels[0].adjacency[u].push_back(std::make_pair(v, 1.0));
+				else
+					it->second += 1;
+			}
+		}
+	}
+
+	//coarsen until the graph is small compared to the number of zones (or matching stops making progress)
+	ULL coarsest_size = std::max((ULL)20, 10 * param_number_of_zones);
+	while (levels.back().node_weights.size() > coarsest_size)
+	{
+		zone_graph coarse = coarsen_zone_graph(levels.back(), zone_generator);
+		if (coarse.node_weights.size() > 0.95 * levels.back().node_weights.size())
+			break;
+		levels.push_back(coarse);
+	}
+
+	//partition the coarsest graph, then project back level by level and refine
+	std::vector<ULL> zone = grow_zones(levels.back(), param_number_of_zones);
+	refine_zones(levels.back(), zone, param_number_of_zones);
+	for (ULL l = levels.size() - 1; l > 0; --l)
+	{
+		std::vector<ULL> fine_zone(levels[l - 1].node_weights.size());
+		for (ULL v = 0; v < fine_zone.size(); ++v)
+			fine_zone[v] = zone[levels[l - 1].coarse_node[v]];
+		zone = fine_zone;
+		refine_zones(levels[l - 1], zone, param_number_of_zones);
+	}
+
+	set_zones(zone, param_number_of_zones);
+}
+
+//store the zone of each node and the nodes of each zone
+void traffic_network::set_zones(std::vector<ULL> param_zone_of_node, ULL param_number_of_zones)
+{
+	assert(param_zone_of_node.size() == number_of_nodes);
+
+	number_of_zones = param_number_of_zones;
+	zone_of_node = param_zone_of_node;
+
+	zone_nodes.assign(number_of_zones, std::vector<ULL>());
+	for (ULL i = 0; i < number_of_nodes; ++i)
+		zone_nodes[zone_of_node[i]].push_back(i);
+
+	calc_zone_distances();
+}
+
+//compute lower and upper bounds for distances between zones from the distance matrix
+void traffic_network::calc_zone_distances()
+{
+	min_zone_distances.assign(number_of_zones * number_of_zones, 1e10);
+	max_zone_distances.assign(number_of_zones * number_of_zones, 0);
+
+	for (ULL i = 0; i < number_of_nodes; ++i)
+	{
+		for (ULL j = 0; j < number_of_nodes; ++j)
+		{
+			ULL zone_pair = zone_of_node[i] * number_of_zones + zone_of_node[j];
+			min_zone_distances[zone_pair] = std::min(min_zone_distances[zone_pair], network_distances[i * number_of_nodes + j]);
+			max_zone_distances[zone_pair] = std::max(max_zone_distances[zone_pair], network_distances[i * number_of_nodes + j]);
+		}
+	}
+}
+
+//count the (directed) links between different zones
+ULL traffic_network::get_number_of_cut_links()
+{
+	ULL cut_links = 0;
+	for (auto& links : edgelist)
+		for (auto& e : links.second)
+			if (zone_of_node[links.first] != zone_of_node[e.first])
+				++cut_links;
+
+	return(cut_links);
+}
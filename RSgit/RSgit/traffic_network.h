@@ -23,6 +23,37 @@
 #define _EPSILON
 #endif
 
+//entry of a neighbour ring: a node and its distance to the center of the ring
+struct ring_entry
+{
+	ULL node_index;
+	double distance;
+
+	ring_entry(ULL param_node_index, double param_distance)
+		: node_index(param_node_index),
+		distance(param_distance)
+	{};
+};
+
+//view on the (contiguously stored) neighbour ring of a node
+//only valid until the next ring is generated (storage may be reallocated)
+struct neighbour_ring
+{
+	const ring_entry* first;
+	const ring_entry* last;		//past-the-end
+	double reach;				//all nodes NOT in the ring are at least this far away from the center
+
+	neighbour_ring(const ring_entry* param_first, const ring_entry* param_last, double param_reach)
+		: first(param_first),
+		last(param_last),
+		reach(param_reach)
+	{};
+
+	const ring_entry* begin() const { return(first); }
+	const ring_entry* end() const { return(last); }
+	ULL size() const { return(last - first); }
+};
+
 class traffic_network
 {
 public:
@@ -36,6 +67,14 @@ public:
 	void add_link(ULL from, ULL to, double dist);
 	void create_distances();
 
+	//contract chains of shape nodes (zero origin and destination probability, exactly two neighbours) into single weighted links
+	//call before create_distances(), nodes are renumbered (see get_original_node), returns the number of removed nodes
+	ULL contract_shape_nodes();
+	ULL get_number_of_nodes() { return(number_of_nodes); }
+	ULL get_number_of_original_nodes() { return(contracted_node_index.size()); }
+	ULL get_original_node(ULL node) { return(original_node_index[node]); }
+	ULL get_contracted_node(ULL original_node) { return(contracted_node_index[original_node]); }	//-1 if the node was removed
+
 	void set_origin_probabilities();		//set to default (uniform distribution)
 	void set_destination_probabilities();	//set to default (uniform distribution)
 	void set_origin_probabilities(std::vector<double> param_probabilities);
@@ -54,8 +93,29 @@ public:
 	}
 
 	double get_network_distance(ULL from, ULL to);	//from i to j
+	const double* get_distance_matrix() { return(network_distances.data()); }	//entry [i * N + j] is the distance from i to j (e.g. for gathering many distances at once)
+
+	//optional neighbour rings: for each node the nodes j within distance param_radius (at most param_max_ring_size of them),
+	//sorted by increasing distance FROM j TO the node (e.g. for finding vehicles that can reach a pickup location first)
+	//rings are generated lazily on first use, memory is bounded by N * param_max_ring_size entries
+	void enable_neighbour_rings(double param_radius, ULL param_max_ring_size);
+	void disable_neighbour_rings();
+	bool has_neighbour_rings() { return(use_neighbour_rings); }
+	neighbour_ring get_neighbour_ring(ULL node);
+	void generate_all_neighbour_rings();	//before the rings are read on several threads (get_neighbour_ring then only reads)
+
+	//zones: balanced partition of the nodes with few links between zones (multilevel coarsening, greedy growing and boundary refinement)
+	//default is a single zone containing all nodes, zone distance bounds are (re)computed with the distance matrix
+	void create_zones(ULL param_number_of_zones);
+	ULL get_number_of_zones() { return(number_of_zones); }
+	ULL get_zone(ULL node) { return(zone_of_node[node]); }
+	const std::vector<ULL>& get_zone_nodes(ULL zone) { return(zone_nodes[zone]); }
+	double get_min_zone_distance(ULL from_zone, ULL to_zone) { return(min_zone_distances[from_zone * number_of_zones + to_zone]); }	//min over all nodes i in from_zone, j in to_zone of the distance from i to j
+	double get_max_zone_distance(ULL from_zone, ULL to_zone) { return(max_zone_distances[from_zone * number_of_zones + to_zone]); }	//max over all nodes i in from_zone, j in to_zone of the distance from i to j
+	ULL get_number_of_cut_links();
 
 	std::pair< ULL, ULL > generate_request();
+	std::pair< ULL, ULL > generate_request(std::mt19937_64& generator);	//from a given generator (e.g. the request stream of the simulation)
 
 	std::deque< std::pair<ULL, double> > find_shortest_path(ULL from, ULL to, double start_time, double velocity); //returns the shortest path (randomly chosen at each node if multiple options exist), !!NOT!! uniformly over all shortest paths.
 
@@ -64,7 +124,30 @@ protected:
 private:
 	ULL number_of_nodes;
 	std::map< ULL, std::set< std::pair<ULL, double> > > edgelist;
-	std::vector< std::vector<double> > network_distances; //entry [i][j] means from i to j (!!!)
+	std::vector< double > network_distances; //entry [i * number_of_nodes + j] means from i to j (!!!)
+
+	std::vector< ULL > original_node_index;		//node index before contraction of shape nodes
+	std::vector< ULL > contracted_node_index;	//node index after contraction of shape nodes (indexed by original node)
+
+	void reset_neighbour_rings();
+	void generate_neighbour_ring(ULL node);
+
+	bool use_neighbour_rings;
+	double neighbour_ring_radius;
+	ULL max_neighbour_ring_size;
+	std::vector< ring_entry > neighbour_ring_entries;	//all generated rings, each stored contiguously
+	std::vector< ULL > neighbour_ring_start;			//start of the ring of each node in neighbour_ring_entries (-1 if not generated yet)
+	std::vector< ULL > neighbour_ring_length;
+	std::vector< double > neighbour_ring_reach;
+
+	void set_zones(std::vector<ULL> param_zone_of_node, ULL param_number_of_zones);
+	void calc_zone_distances();
+
+	ULL number_of_zones;
+	std::vector< ULL > zone_of_node;
+	std::vector< std::vector<ULL> > zone_nodes;
+	std::vector< double > min_zone_distances;	//entry [a * number_of_zones + b] means from zone a to zone b
+	std::vector< double > max_zone_distances;
 
 	std::vector<double> origin_probabilities;
 	std::vector<double> destination_probabilities;
@@ -1,4 +1,5 @@
 #include "transporter.h"
+#include "customer_pool.h"
 
 //constructor, initialize all necessary variables
 transporter::transporter(ULL param_index, ULL param_location, ULL param_type, std::mt19937_64 param_random_generator) : random_generator(param_random_generator)
@@ -18,10 +19,25 @@ transporter::transporter(ULL param_index, ULL param_location, ULL param_type, st
 	//bus has no current route, assigned stops or customers
 	current_route.clear();
 	assigned_stops.clear();
-	assigned_customers.clear();
+	number_of_assigned_customers = 0;
+	stop_nodes.clear();
+	planned_arrival_times.clear();
+	remaining_slack.clear();
+	occupancy_before_stop.clear();
+
+	//only the current schedule is kept (see enable_kinetic_tree)
+	use_kinetic_tree = false;
+
+	//parameters of the default type (see set_fleet_types)
+	fleet_types = NULL;
+
+	//no admission limits (see set_admission_limits)
+	max_wait = std::numeric_limits<double>::infinity();
+	max_planned_stops = std::numeric_limits<ULL>::max();
 
 	//bus is idle
 	idle = true;
+	schedule_version = 0;
 
 	//set type of bus and initialize parameters accordingly
 	type = param_type;
@@ -42,9 +58,15 @@ void transporter::reset(ULL param_index, ULL param_location, ULL param_type)
 
 	current_route.clear();
 	assigned_stops.clear();
-	assigned_customers.clear();
+	number_of_assigned_customers = 0;
+	stop_nodes.clear();
+	planned_arrival_times.clear();
+	remaining_slack.clear();
+	occupancy_before_stop.clear();
+	schedule_tree.reset(0);
 
 	idle = true;
+	++schedule_version;
 
 	type = param_type;
 	init_by_type();
@@ -55,12 +77,11 @@ transporter::~transporter()
 {
 	current_route.clear();
 	assigned_stops.clear();
-	assigned_customers.clear();
 }
 
 //execute next event for the transporter (arrive at next node on route)
 //returns the time of the next event (or -1 number if none)
-double transporter::execute_event(double time, traffic_network& n, measurement_collector& m, ULL& total_serviced_requests, bool do_measurement)
+double transporter::execute_event(double time, traffic_network& n, customer_pool& customers, measurement_collector& m, ULL& total_serviced_requests, bool do_measurement)
 {
 	//make sure nothing broke in the simulation and we are actually on the route we are supposed to be on at the right time
 	assert(!current_route.empty());
@@ -69,14 +90,17 @@ double transporter::execute_event(double time, traffic_network& n, measurement_c
 	assert(current_time == time);
 
 	current_route.pop_front();
+	double next_event_time;
 
 	//if stop event (pickup, dropoff, other) --> execute  [arriving at a node where something happens, not just passing through]
 	if (current_route.empty())
 	{
 		//process stop from list of assigned stops
 		assert(!assigned_stops.empty());
-		stop current_stop = (*assigned_stops.begin());
+		stop current_stop = assigned_stops.front();
 		assigned_stops.erase(assigned_stops.begin());
+		if (use_kinetic_tree)
+			schedule_tree.complete_first_stop();
 
 		assert(current_location == current_stop.node_index);
 
@@ -88,46 +112,50 @@ double transporter::execute_event(double time, traffic_network& n, measurement_c
 		}
 
 		//pickup event
-		if (current_stop.is_pickup)
+		if (current_stop.is_pickup())
 		{
 			//pickup customer
 			++occupancy;
-			current_stop.c_it->set_pickup_time(current_time);
+			customers.get_customer(current_stop.c).set_pickup_time(current_time);
 
 			assert(capacity < 0 || occupancy <= capacity);
 
 		}
-		else if (current_stop.is_dropoff)	//dropoff event
+		else if (current_stop.is_dropoff())	//dropoff event
 		{
 			//drop off customer
 			--occupancy;
-			current_stop.c_it->set_dropoff_time(current_time);
+			customers.get_customer(current_stop.c).set_dropoff_time(current_time);
 
 			assert(occupancy >= 0);
 
 			//measure the request
 			++total_serviced_requests;
 			if (do_measurement)
-				m.measure_request(*(current_stop.c_it), *this);
+				m.measure_request(customers.get_customer(current_stop.c), *this);
 
-			//customer is served and deleted from the system
-			assigned_customers.erase(current_stop.c_it);
+			//customer is served and removed from the system
+			--number_of_assigned_customers;
+			customers.release_customer(current_stop.c);
 		}
 		else
 		{
 			//if other event, handle by type (nothing implemented so far, unused)
-			return(handle_event_by_type(time, n, current_stop));
+			next_event_time = handle_event_by_type(time, n, current_stop);
 		}
 
-		//if further stops planned, start driving there
-		if (!assigned_stops.empty())
+		if (current_stop.is_pickup() || current_stop.is_dropoff())
 		{
-			return(new_route(n.find_shortest_path(current_location, assigned_stops.begin()->node_index, current_time, velocity)));
-		}
-		else {//else become idle ( TODO: add drive back to random/nearest origin to balance asymmetric requests )
+			//if further stops planned, start driving there
+			if (!assigned_stops.empty())
+			{
+				next_event_time = new_route(n.find_shortest_path(current_location, assigned_stops.front().node_index, current_time, velocity));
+			}
+			else {//else become idle ( TODO: add drive back to random/nearest origin to balance asymmetric requests )
 
-			idle = true;
-			return(-1);	//no further event for this bus
+				idle = true;
+				next_event_time = -1;	//no further event for this bus
+			}
 		}
 
 	}
@@ -136,15 +164,20 @@ double transporter::execute_event(double time, traffic_network& n, measurement_c
 		current_location = current_route.front().first;
 		current_time = current_route.front().second;
 
-		return(current_time);
+		next_event_time = current_time;
 	}
+
+	//position of the bus (and maybe its stops) changed, remaining slack has to be recomputed
+	update_schedule(n);
+
+	return(next_event_time);
 }
 
 //update current route of the bus
 double transporter::new_route(std::deque< std::pair<ULL, double> > param_new_route)
 {
 	//make sure the route is still current and goes to the next assigned stop
-	assert(param_new_route.back().first == assigned_stops.begin()->node_index);
+	assert(param_new_route.back().first == assigned_stops.front().node_index);
 
 	//if not currently driving, simply start driving
 	if (current_route.empty())
@@ -162,17 +195,75 @@ double transporter::new_route(std::deque< std::pair<ULL, double> > param_new_rou
 	return(current_route.front().second);
 }
 
+//lower bound for the dropoff time of any offer this transporter can make for the request:
+//drive directly from the next node on the route to the origin and then to the destination
+//(for idle transporters this is exactly the offer, computed the same way as in best_offer)
+//
+//best_offer plans a dropoff after later stops at the planned arrival at the stop before plus the drive to the destination, without the delay from the pickup
+//if the pickup may delay the stops (remaining slack above epsilon), such a dropoff can be earlier than the direct drive by up to the delay of the pickup,
+//which is at most the remaining slack of the last stop (the largest of all stops), but never earlier than driving directly to the destination
+//(with a kinetic tree, the dropoff times include the delay from the pickup)
+double transporter::dropoff_time_bound(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n)
+{
+	double earliest_pickup_time = std::max(current_time, param_request_time) + n.get_network_distance(current_location, param_origin) / velocity;
+	double bound = earliest_pickup_time + n.get_network_distance(param_origin, param_destination) / velocity;
+
+	if (!assigned_stops.empty() && !use_kinetic_tree)
+	{
+		double max_pickup_delay = remaining_slack[assigned_stops.size() - 1];
+		if (max_pickup_delay > MACRO_EPSILON)
+			bound = std::max(bound - max_pickup_delay, std::max(current_time, param_request_time) + n.get_network_distance(current_location, param_destination) / velocity);
+	}
+
+	return(bound);
+}
+
+//an insertion replaces the best offer if it is better, or equally good and this bus has at least the occupancy of the bus of the best offer
+template<class objective>
+bool transporter::improves_offer(double request_time, double pickup_time, double dropoff_time, double added_vehicle_time, const offer& best)
+{
+	typedef objective_comparison<objective> compare;
+
+	return(best.best_transporter == NULL ||
+		compare::is_better(request_time, pickup_time, dropoff_time, added_vehicle_time, best.pickup_time, best.dropoff_time, best.added_vehicle_time) ||
+		(compare::is_equal(request_time, pickup_time, dropoff_time, added_vehicle_time, best.pickup_time, best.dropoff_time, best.added_vehicle_time) && occupancy >= best.best_transporter->get_occupancy()));
+}
+
 //return best offer for the customer given the request and the currently best offer from all other buses
 
 // this defines the dispatcher algorithm
 // currently:
-//		minimize arrival time (if multiple choices, secondary objective maximizes the pickup time, tertiary objective uses the bus with the larger occupancy)
+//		minimize the cost of the objective (default: arrival time; if multiple choices, the tie cost decides, e.g. maximize the pickup time; then use the bus with the larger occupancy)
 //		under the constraint that other customers are not delayed more than a given factor beyond their initially promised arrival time [this is a customer parameter]
 //		all conditions checked to within epsilon precision (to avoid problems due to addition along the route of a bus)
+//		the objective is a template parameter, see dispatch_objective.h
 //
 
-offer transporter::best_offer(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer)
+template<class objective>
+offer transporter::best_offer(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer, ULL max_pickup_positions)
+{
+	//kernel of the type of the transporter: for types with infinite capacity the capacity checks are left out
+	//(the fleet is grouped by type, see ridesharing_sim::set_fleet_composition, so this branch is taken the same way for long runs of transporters)
+	offer best_offer;
+	if (capacity < 0)
+		best_offer = best_offer_by_capacity<objective, false>(param_origin, param_destination, param_request_time, n, current_best_offer, max_pickup_positions);
+	else
+		best_offer = best_offer_by_capacity<objective, true>(param_origin, param_destination, param_request_time, n, current_best_offer, max_pickup_positions);
+
+	//the insertions of the offer refer to the current schedule
+	if (best_offer.is_better_offer)
+		best_offer.schedule_version = schedule_version;
+	return(best_offer);
+}
+
+//best offer with (limited_capacity) or without capacity checks (the capacity must be infinite)
+template<class objective, bool limited_capacity>
+offer transporter::best_offer_by_capacity(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer, ULL max_pickup_positions)
 {
+	typedef objective_comparison<objective> compare;
+
+	assert(limited_capacity || capacity < 0);
+
 	//request parameters
 	ULL origin = param_origin;
 	ULL destination = param_destination;
@@ -180,27 +271,22 @@ offer transporter::best_offer(ULL param_origin, ULL param_destination, double pa
 
 	//variables for inserting the request in the scheduled route
 	double temp_time_for_pickup = std::max(current_time, request_time);
-	double temp_time_for_dropoff;
 	double pickup_time;
 	double dropoff_time;
-	ULL delay_location;
-	double delay_time;
-	std::list< stop >::iterator temp_pickup_insertion;   // Pickup will be inserted BEFORE the list item to which the iterator points
-	std::list< stop >::iterator temp_dropoff_insertion;  // Dropoff will be inserted BEFORE the list item to which the iterator points
-	std::list< stop >::iterator check_delay_it;
-
-	bool pickup_is_possible = false;
-	bool dropoff_is_possible = false;
-	double delay_from_pickup;
-	double delay_from_dropoff;
 
 	//current best offer
-	offer best_offer(current_best_offer.transporter_index, current_best_offer.best_transporter, current_best_offer.pickup_time, current_best_offer.pickup_insertion, current_best_offer.dropoff_time, current_best_offer.dropoff_insertion);
+	offer best_offer = current_best_offer;
+	best_offer.is_better_offer = false;
 
-	ULL temp_location_for_pickup = current_location;
-	ULL temp_location = current_location;
-	LL occupancy_before_pickup = occupancy;
-	LL occupancy_after_pickup = occupancy;
+	//an insertion replaces the best offer if it is better, or equally good and this bus has at least the occupancy of the bus of the best offer
+	auto improves_best_offer = [&](double param_pickup_time, double param_dropoff_time, double param_added_vehicle_time)
+	{
+		return(improves_offer<objective>(request_time, param_pickup_time, param_dropoff_time, param_added_vehicle_time, best_offer));
+	};
+
+	//admission limits: a full schedule or a pickup later than the maximal wait (even when driving directly to the origin) cannot make an offer
+	if (!has_room_for_customer() || (max_wait < std::numeric_limits<double>::infinity() && temp_time_for_pickup + n.get_network_distance(current_location, origin) / velocity - request_time > max_wait + MACRO_EPSILON))
+		return(best_offer);
 
 	//special case if the bus is idle
 	if (idle)
@@ -208,278 +294,367 @@ offer transporter::best_offer(ULL param_origin, ULL param_destination, double pa
 		//compute possible pickup and dropoff times
 		pickup_time = temp_time_for_pickup + n.get_network_distance(current_location, origin) / velocity;
 		dropoff_time = pickup_time + n.get_network_distance(origin, destination) / velocity;
+		double added_vehicle_time = n.get_network_distance(current_location, origin) / velocity + n.get_network_distance(origin, destination) / velocity;
+
+		best_offer = idle_offer<objective>(request_time, pickup_time, dropoff_time, added_vehicle_time, current_best_offer);
+
+		//sanity check just to make sure nothing weird is going on
+		assert(best_offer.is_better_offer || !objective::dropoff_time_is_cost || current_location != origin || pickup_time <= best_offer.pickup_time);
+
+		return(best_offer);
+	}
+
+	COUNT_DISPATCH_WORK(transporters_evaluated, 1);
 
-		//new stops would be inserted at the end of the scheduled stop (since none are planned, the bus is idle)
-		temp_pickup_insertion = assigned_stops.end();
-		temp_dropoff_insertion = assigned_stops.end();
+	//with a kinetic tree, walk all feasible orderings of the stops instead of only the current schedule
+	if (use_kinetic_tree)
+	{
+		assert(!assigned_stops.empty() && schedule_tree.get_number_of_stops() == assigned_stops.size() && current_time >= request_time);
 
-		//if better offer, remember
-		if (dropoff_time < best_offer.dropoff_time - MACRO_EPSILON ||
-			(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && pickup_time > best_offer.pickup_time + MACRO_EPSILON) ||
-			(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy > best_offer.best_transporter->get_occupancy())) ||
-			(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy == best_offer.best_transporter->get_occupancy()))
-			)
+		kinetic_insertion insertion;
+		double dropoff_time_limit = (objective::dropoff_time_is_cost ? best_offer.dropoff_time : std::numeric_limits<double>::infinity());
+		if (schedule_tree.best_insertion<objective>(origin, destination, request_time, dropoff_time_limit, max_pickup_positions, n, insertion) && improves_best_offer(insertion.pickup_time, insertion.dropoff_time, insertion.added_vehicle_time))
 		{
 			best_offer.transporter_index = index;
 			best_offer.best_transporter = this;
-			best_offer.pickup_insertion = temp_pickup_insertion;
-			best_offer.dropoff_insertion = temp_dropoff_insertion;
-			best_offer.pickup_time = pickup_time;
-			best_offer.dropoff_time = dropoff_time;
+			best_offer.pickup_insertion = insertion.pickup_insertion;
+			best_offer.dropoff_insertion = insertion.dropoff_insertion;
+			best_offer.pickup_time = insertion.pickup_time;
+			best_offer.dropoff_time = insertion.dropoff_time;
+			best_offer.added_vehicle_time = insertion.added_vehicle_time;
+			best_offer.ordering = insertion.ordering;
 			best_offer.is_better_offer = true;
 		}
-		else {
-			//sanity check just to make sure nothing weird is going on
-			assert(current_location != origin || pickup_time <= best_offer.pickup_time);
-		}
-
-		return(best_offer);
 	}
-
-	//only do all the checking if there can be a better offer
-	if (current_time + n.get_network_distance(current_location, origin) / velocity + n.get_network_distance(origin, destination) / velocity < best_offer.dropoff_time + MACRO_EPSILON)
+	//only do all the checking if there can be a better offer (if the cost is not the dropoff time, there is no such bound)
+	else if (!objective::dropoff_time_is_cost || dropoff_time_bound(origin, destination, request_time, n) < best_offer.dropoff_time + MACRO_EPSILON)
 	{
-		temp_dropoff_insertion = assigned_stops.end();
+		//schedule data has to be up to date (and the bus cannot be behind the request if it is not idle)
+		assert(!assigned_stops.empty() && planned_arrival_times.size() == assigned_stops.size() && current_time >= request_time);
+
+		//find the best insertion of pickup and dropoff in linear time instead of trying all pairs of positions
+		//
+		//position k means inserting BEFORE the k-th stop (k = number of stops is the end of the schedule)
+		//a dropoff at position D after a pickup at an earlier position P < D happens at the same time for all P (the bus arrives at the stop before D as planned,
+		//delays from the pickup are only checked for the pickup itself), so for each D only the best possible pickup before D is needed: the latest pickup time
+		//
+		//the result is the same as trying all pairs (pickups in order of the schedule, for each pickup all later dropoffs in order) and replacing the
+		//best offer by each better or equally good one, i.e. of all equally good insertions the last one in that order is chosen
+		//that search stops trying pickups once the earliest possible dropoff via the next pickup position is later than the best offer so far, which
+		//is reproduced by tracking the earliest dropoff of each pickup position
+		//(a dropoff at a later position does not include the delay from the pickup, so if the pickups may delay the stops, this also needs all later dropoffs to be too late)
+		//
+		//this only holds if the cost is the dropoff time, for other objectives all pairs are tried (each still checked in O(1))
+		struct pickup_candidate
+		{
+			ULL position;
+			double pickup_time;
+			double delay;		//delay of the following stops caused by the pickup (= added driving time)
+		};
+
+		ULL number_of_stops = assigned_stops.size();
+		double no_dropoff = std::numeric_limits<double>::infinity();
+
+		//dropoff before the k-th stop with pickup somewhere before (independent of the pickup position)
+		//reused buffers, best_offer may be called for different transporters from different threads
+		static thread_local std::vector<double> dropoff_times;
+		static thread_local std::vector<double> dropoff_delays;
+		static thread_local std::vector<double> dropoff_detours;				//added driving time (differs from the delay only at the end of the schedule)
+		static thread_local std::vector<bool> dropoff_within_slack;
+		static thread_local std::vector<double> earliest_checked_dropoff;		//earliest possible dropoff at this or a later position (until the customer no longer fits), if the dropoff delays the following stops
+		static thread_local std::vector<double> earliest_unchecked_dropoff;	//same, if pickup and dropoff together do not delay the following stops
+		static thread_local std::vector<double> earliest_later_dropoff;		//earliest dropoff at this or a later position, possible or not (one more entry: none)
+		dropoff_times.resize(number_of_stops + 1);
+		dropoff_delays.resize(number_of_stops + 1);
+		dropoff_detours.resize(number_of_stops + 1);
+		dropoff_within_slack.resize(number_of_stops + 1);
+		earliest_checked_dropoff.resize(number_of_stops + 1);
+		earliest_unchecked_dropoff.resize(number_of_stops + 1);
+		earliest_later_dropoff.resize(number_of_stops + 2);
+
+		ULL temp_location = current_location;
+		ULL k;
+		for (k = 0; k < number_of_stops; ++k)
+		{
+			if (k > 0)
+			{
+				dropoff_times[k] = planned_arrival_times[k - 1] + n.get_network_distance(temp_location, destination) / velocity;
+				dropoff_delays[k] = std::max(0.0, (n.get_network_distance(temp_location, destination) / velocity + n.get_network_distance(destination, stop_nodes[k]) / velocity - n.get_network_distance(temp_location, stop_nodes[k]) / velocity));
+				dropoff_detours[k] = dropoff_delays[k];
+				dropoff_within_slack[k] = (dropoff_times[k] + n.get_network_distance(destination, stop_nodes[k]) / velocity - planned_arrival_times[k] <= remaining_slack[k]);
+			}
+			temp_location = stop_nodes[k];
+		}
+		COUNT_DISPATCH_WORK(delay_check_iterations, number_of_stops);
+		//drop off at the end of the schedule, no need to check delay, since no customer is delayed by drop off
+		dropoff_times[number_of_stops] = (number_of_stops > 0 ? planned_arrival_times[number_of_stops - 1] : temp_time_for_pickup) + n.get_network_distance(temp_location, destination) / velocity;
+		dropoff_delays[number_of_stops] = 0;
+		dropoff_detours[number_of_stops] = n.get_network_distance(temp_location, destination) / velocity;
+		dropoff_within_slack[number_of_stops] = true;
+
+		//best insertion found so far
+		bool found_insertion = false;
+		ULL found_pickup_position = 0;
+		ULL found_dropoff_position = 0;
+		double found_pickup_time = 0;
+		double found_dropoff_time = 0;
+		double found_added_vehicle_time = 0;
+
+		//remember an insertion if it is better than the best one so far or equally good and later in the order of the pairs
+		auto consider_insertion = [&](const pickup_candidate& pickup, ULL dropoff_position, double dropoff_time, double added_vehicle_time)
+		{
+			COUNT_DISPATCH_WORK(dropoff_positions, 1);
+			if (!found_insertion ||
+				compare::is_better(request_time, pickup.pickup_time, dropoff_time, added_vehicle_time, found_pickup_time, found_dropoff_time, found_added_vehicle_time) ||
+				(compare::is_equal(request_time, pickup.pickup_time, dropoff_time, added_vehicle_time, found_pickup_time, found_dropoff_time, found_added_vehicle_time) && (pickup.position > found_pickup_position || (pickup.position == found_pickup_position && dropoff_position > found_dropoff_position)))
+				)
+			{
+				found_insertion = true;
+				found_pickup_position = pickup.position;
+				found_dropoff_position = dropoff_position;
+				found_pickup_time = pickup.pickup_time;
+				found_dropoff_time = dropoff_time;
+				found_added_vehicle_time = added_vehicle_time;
+			}
+		};
 
-		//iterate over all possible insertions of pickup and delivery into the scheduled route of the bus
-		//REMARK: std::list<>::end() returns past-the-end element, meaning the list element that follows the last stop
-		for (temp_pickup_insertion = assigned_stops.begin(); temp_pickup_insertion != assigned_stops.end(); ++temp_pickup_insertion)
+		//pickup before the k-th stop, coming from temp_location at temp_time (false if not possible due to the capacity or the delay of the following stops)
+		auto try_pickup = [&](ULL k, double temp_time, ULL temp_location, pickup_candidate& pickup)
 		{
-			pickup_time = temp_time_for_pickup + n.get_network_distance(temp_location_for_pickup, origin) / velocity;	//time of pickup
-			temp_time_for_dropoff = temp_time_for_pickup;
-			pickup_is_possible = true;
+			COUNT_DISPATCH_WORK(pickup_positions, 1);
+			pickup_time = temp_time + n.get_network_distance(temp_location, origin) / velocity;
 
 			//check if transporter capacity allows for pickup
-			if (capacity > 0 && occupancy_before_pickup >= capacity)
-				pickup_is_possible = false;
+			if (limited_capacity && capacity > 0 && occupancy_before_stop[k] >= capacity)
+				return(false);
 
 			//calculate the delay from adding the pickup here
-			delay_from_pickup = std::max(0.0, (n.get_network_distance(temp_location_for_pickup, origin) / velocity + n.get_network_distance(origin, temp_pickup_insertion->node_index) / velocity) - n.get_network_distance(temp_location_for_pickup, temp_pickup_insertion->node_index) / velocity);
-			//check all following stops if this pickup is allowed or not
-			if (pickup_is_possible && delay_from_pickup > MACRO_EPSILON)
+			double delay_from_pickup = std::max(0.0, (n.get_network_distance(temp_location, origin) / velocity + n.get_network_distance(origin, stop_nodes[k]) / velocity) - n.get_network_distance(temp_location, stop_nodes[k]) / velocity);
+			//check if this pickup is allowed or not: all following stops are delayed by the same amount, which must not exceed their remaining slack
+			if (delay_from_pickup > MACRO_EPSILON)
 			{
-				delay_location = origin;
-				delay_time = pickup_time;
+				if (pickup_time + n.get_network_distance(origin, stop_nodes[k]) / velocity - planned_arrival_times[k] > remaining_slack[k])
+					return(false);
+			}
 
-				for (check_delay_it = temp_pickup_insertion; check_delay_it != assigned_stops.end(); ++check_delay_it)
-				{
-					//if delayed time until dropoff is larger than allowed delay factor times remaining time until promised stop, not allowed
-					if (check_delay_it->is_dropoff && (delay_time + n.get_network_distance(delay_location, check_delay_it->node_index) / velocity - current_time) > check_delay_it->c_it->get_allowed_dropoff_delay() * (check_delay_it->c_it->get_offer_dropoff_time() - current_time + MACRO_EPSILON))
-					{
-						pickup_is_possible = false;
-						break;
-					}
-					//if delayed time until pickup is larger than allowed delay factor times remaining time until promised stop, not allowed
-					if (check_delay_it->is_pickup && (delay_time + n.get_network_distance(delay_location, check_delay_it->node_index) / velocity - current_time) > check_delay_it->c_it->get_allowed_pickup_delay() * (check_delay_it->c_it->get_offer_pickup_time() - current_time + MACRO_EPSILON))
-					{
-						pickup_is_possible = false;
-						break;
-					}
+			pickup = { k, pickup_time, delay_from_pickup };
+			return(true);
+		};
 
-					//advance to compute remaining time along the route
-					delay_time += n.get_network_distance(delay_location, check_delay_it->node_index) / velocity;
-					delay_location = check_delay_it->node_index;
-				}
+		//drop off immediately after the pickup, before going to the k-th stop (false if the following stops are delayed too much)
+		auto try_immediate_dropoff = [&](ULL k, ULL temp_location, const pickup_candidate& pickup, double& delay_from_dropoff)
+		{
+			dropoff_time = pickup.pickup_time + n.get_network_distance(origin, destination) / velocity;
+			delay_from_dropoff = std::max(0.0, n.get_network_distance(temp_location, origin) / velocity + n.get_network_distance(origin, destination) / velocity + n.get_network_distance(destination, stop_nodes[k]) / velocity - n.get_network_distance(temp_location, stop_nodes[k]) / velocity);
+			return(delay_from_dropoff <= MACRO_EPSILON || dropoff_time + n.get_network_distance(destination, stop_nodes[k]) / velocity - planned_arrival_times[k] <= remaining_slack[k]);
+		};
+
+		double temp_time = temp_time_for_pickup;
+		temp_location = current_location;
+		bool try_pickup_at_end = true;
+		if (objective::dropoff_time_is_cost)
+		{
+			//earliest dropoffs, backwards from the end of the schedule
+			earliest_checked_dropoff[number_of_stops] = dropoff_times[number_of_stops];
+			earliest_unchecked_dropoff[number_of_stops] = dropoff_times[number_of_stops];
+			earliest_later_dropoff[number_of_stops + 1] = no_dropoff;
+			earliest_later_dropoff[number_of_stops] = dropoff_times[number_of_stops];
+			for (k = number_of_stops - 1; k >= 1; --k)	//a bus that is not idle has at least one stop
+			{
+				earliest_later_dropoff[k] = std::min(dropoff_times[k], earliest_later_dropoff[k + 1]);
+
+				//the customer cannot be in the bus while passing the k-th stop due to limited capacity
+				bool customer_fits = !(limited_capacity && capacity >= 0 && occupancy_before_stop[k + 1] + 1 > capacity);
+
+				earliest_checked_dropoff[k] = std::min(dropoff_within_slack[k] ? dropoff_times[k] : no_dropoff, customer_fits ? earliest_checked_dropoff[k + 1] : no_dropoff);
+				earliest_unchecked_dropoff[k] = std::min(dropoff_within_slack[k] || dropoff_delays[k] <= MACRO_EPSILON ? dropoff_times[k] : no_dropoff, customer_fits ? earliest_unchecked_dropoff[k + 1] : no_dropoff);
 			}
+			COUNT_DISPATCH_WORK(delay_check_iterations, number_of_stops - 1);
+
+			//best pickup before the current position, among all possible pickups and among those that do not delay any other stop
+			pickup_candidate best_pickup = { 0, 0, 0 };
+			bool has_best_pickup = false;
+			pickup_candidate best_pickup_without_delay = { 0, 0, 0 };
+			bool has_best_pickup_without_delay = false;
+			static thread_local std::vector<pickup_candidate> pickups_with_negligible_delay;	//delay above zero but within epsilon, has to be checked for each dropoff
+			pickups_with_negligible_delay.clear();
+
+			//earliest dropoff of the best offer so far (including the current best offer), decides if further pickup positions need to be tried
+			double earliest_dropoff = best_offer.dropoff_time;
+			bool try_pickups = true;
+
+			//largest delay of the stops a pickup may cause (the remaining slack of the last stop is the largest of all stops)
+			bool pickups_may_delay_stops = (remaining_slack[number_of_stops - 1] > MACRO_EPSILON);
 
-			if (pickup_is_possible)
+			//remember a pickup if its pickup time is later or equal (later positions win ties)
+			auto update_best_pickup = [](pickup_candidate& best, bool& has_best, const pickup_candidate& pickup)
 			{
-				//track the number of people on the bus
-				occupancy_after_pickup = occupancy_before_pickup + 1;
-				temp_location = temp_location_for_pickup;
-				for (temp_dropoff_insertion = temp_pickup_insertion; temp_dropoff_insertion != assigned_stops.end(); ++temp_dropoff_insertion)
+				if (!has_best || !(pickup.pickup_time < best.pickup_time - MACRO_EPSILON))
 				{
-					//if drop off immediately after pickup, before going to the next scheduled stop
-					if (temp_dropoff_insertion == temp_pickup_insertion)
-					{
-						dropoff_time = pickup_time + n.get_network_distance(origin, destination) / velocity;
-						delay_from_dropoff = std::max(0.0, n.get_network_distance(temp_location, origin) / velocity + n.get_network_distance(origin, destination) / velocity + n.get_network_distance(destination, temp_dropoff_insertion->node_index) / velocity - n.get_network_distance(temp_location, temp_dropoff_insertion->node_index) / velocity);
-						dropoff_is_possible = true;
-
-						//if this is a better dropoff
-						if (dropoff_time < best_offer.dropoff_time - MACRO_EPSILON ||
-							(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && pickup_time > best_offer.pickup_time + MACRO_EPSILON) ||
-							(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy > best_offer.best_transporter->get_occupancy())) ||
-							(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy == best_offer.best_transporter->get_occupancy()))
-							)
-						{
-
-							//THEN check if it is possible, because this is likely more costly
-							//check only if delay is relevant
-							if (dropoff_is_possible && delay_from_dropoff > MACRO_EPSILON)
-							{
-								delay_location = destination;
-								delay_time = dropoff_time;
-
-								for (check_delay_it = temp_dropoff_insertion; check_delay_it != assigned_stops.end(); ++check_delay_it)
-								{
-									if (check_delay_it->is_dropoff && (delay_time + n.get_network_distance(delay_location, check_delay_it->node_index) / velocity - current_time) > check_delay_it->c_it->get_allowed_dropoff_delay() * (check_delay_it->c_it->get_offer_dropoff_time() - current_time + MACRO_EPSILON))
-									{
-										dropoff_is_possible = false;
-										break;
-									}
-
-									if (check_delay_it->is_pickup && (delay_time + n.get_network_distance(delay_location, check_delay_it->node_index) / velocity - current_time) > check_delay_it->c_it->get_allowed_pickup_delay() * (check_delay_it->c_it->get_offer_pickup_time() - current_time + MACRO_EPSILON))
-									{
-										dropoff_is_possible = false;
-										break;
-									}
-
-									delay_time += n.get_network_distance(delay_location, check_delay_it->node_index) / velocity;
-									delay_location = check_delay_it->node_index;
-								}
-							}
+					best = pickup;
+					has_best = true;
+				}
+			};
 
-							//if the drop off is actually possible, remember it as the best option
-							if (dropoff_is_possible)
-							{
-								best_offer.transporter_index = index;
-								best_offer.best_transporter = this;
-								best_offer.pickup_insertion = temp_pickup_insertion;
-								best_offer.dropoff_insertion = temp_dropoff_insertion;
-								best_offer.pickup_time = pickup_time;
-								best_offer.dropoff_time = dropoff_time;
-								best_offer.is_better_offer = true;
-							}
-						}
+			for (k = 0; k < number_of_stops; ++k)
+			{
+				//no pickup left for the remaining dropoff positions
+				if (!try_pickups && !has_best_pickup)
+					break;
+
+				//dropoff before the k-th stop with pickup somewhere before
+				if (has_best_pickup)
+				{
+					//if the remaining slack allows the delay, every possible pickup before can be used
+					if (dropoff_within_slack[k])
+						consider_insertion(best_pickup, k, dropoff_times[k], best_pickup.delay + dropoff_detours[k]);
+					else {
+						//otherwise, only if pickup and dropoff together do not delay the following stops
+						if (has_best_pickup_without_delay && dropoff_delays[k] <= MACRO_EPSILON)
+							consider_insertion(best_pickup_without_delay, k, dropoff_times[k], best_pickup_without_delay.delay + dropoff_detours[k]);
+						for (pickup_candidate& pickup : pickups_with_negligible_delay)
+							if (pickup.delay + dropoff_delays[k] <= MACRO_EPSILON)
+								consider_insertion(pickup, k, dropoff_times[k], pickup.delay + dropoff_detours[k]);
+					}
+				}
+
+				//the customer cannot be in the bus while passing the k-th stop due to limited capacity
+				bool customer_fits = !(limited_capacity && capacity >= 0 && occupancy_before_stop[k + 1] + 1 > capacity);
 
+				//pickup before the k-th stop
+				pickup_candidate pickup = { 0, 0, 0 };
+				if (try_pickups && k < max_pickup_positions && try_pickup(k, temp_time, temp_location, pickup))
+				{
+					//drop off immediately after pickup, before going to the k-th stop
+					double delay_from_dropoff;
+					if (try_immediate_dropoff(k, temp_location, pickup, delay_from_dropoff))
+					{
+						consider_insertion(pickup, k, dropoff_time, delay_from_dropoff);
+						earliest_dropoff = std::min(earliest_dropoff, dropoff_time);
 					}
-					else {	//if drop off somewhere on route
-						dropoff_time = temp_time_for_dropoff + n.get_network_distance(temp_location, destination) / velocity;
-						delay_from_dropoff = delay_from_pickup + std::max(0.0, (n.get_network_distance(temp_location, destination) / velocity + n.get_network_distance(destination, temp_dropoff_insertion->node_index) / velocity - n.get_network_distance(temp_location, temp_dropoff_insertion->node_index) / velocity));
-						dropoff_is_possible = true;
-
-						//if this is a better dropoff
-						if (dropoff_time < best_offer.dropoff_time - MACRO_EPSILON ||
-							(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && pickup_time > best_offer.pickup_time + MACRO_EPSILON) ||
-							(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy > best_offer.best_transporter->get_occupancy())) ||
-							(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy == best_offer.best_transporter->get_occupancy()))
-							)
-						{
-							//THEN check if it is possible, because this is likely more costly
-							//check only if delay is relevant
-							if (dropoff_is_possible && delay_from_dropoff > MACRO_EPSILON)
-							{
-								delay_location = destination;
-								delay_time = dropoff_time;
-
-								for (check_delay_it = temp_dropoff_insertion; check_delay_it != assigned_stops.end(); ++check_delay_it)
-								{
-									if (check_delay_it->is_dropoff && (delay_time + n.get_network_distance(delay_location, check_delay_it->node_index) / velocity - current_time) > check_delay_it->c_it->get_allowed_dropoff_delay() * (check_delay_it->c_it->get_offer_dropoff_time() - current_time + MACRO_EPSILON))
-									{
-										dropoff_is_possible = false;
-										break;
-									}
-									if (check_delay_it->is_pickup && (delay_time + n.get_network_distance(delay_location, check_delay_it->node_index) / velocity - current_time) > check_delay_it->c_it->get_allowed_pickup_delay() * (check_delay_it->c_it->get_offer_pickup_time() - current_time + MACRO_EPSILON))
-									{
-										dropoff_is_possible = false;
-										break;
-									}
-
-									delay_time += n.get_network_distance(delay_location, check_delay_it->node_index) / velocity;
-									delay_location = check_delay_it->node_index;
-								}
-							}
 
-							//if the drop off is actually possible, remember it as the best option
-							if (dropoff_is_possible)
+					//earliest dropoff at a later position
+					if (customer_fits)
+					{
+						if (pickup.delay == 0)
+							earliest_dropoff = std::min(earliest_dropoff, earliest_unchecked_dropoff[k + 1]);
+						else if (pickup.delay > MACRO_EPSILON)
+							earliest_dropoff = std::min(earliest_dropoff, earliest_checked_dropoff[k + 1]);
+						else {
+							for (ULL later_position = k + 1; later_position <= number_of_stops; ++later_position)
 							{
-								best_offer.transporter_index = index;
-								best_offer.best_transporter = this;
-								best_offer.pickup_insertion = temp_pickup_insertion;
-								best_offer.dropoff_insertion = temp_dropoff_insertion;
-								best_offer.pickup_time = pickup_time;
-								best_offer.dropoff_time = dropoff_time;
-								best_offer.is_better_offer = true;
+								COUNT_DISPATCH_WORK(delay_check_iterations, 1);
+								if (dropoff_within_slack[later_position] || pickup.delay + dropoff_delays[later_position] <= MACRO_EPSILON)
+									earliest_dropoff = std::min(earliest_dropoff, dropoff_times[later_position]);
+								if (later_position < number_of_stops && limited_capacity && capacity >= 0 && occupancy_before_stop[later_position + 1] + 1 > capacity)
+									break;
 							}
 						}
 					}
 
-					//advance location, occupancy etc. to check the next stop for dropoff
-					temp_time_for_dropoff += n.get_network_distance(temp_location, temp_dropoff_insertion->node_index) / velocity;
-					temp_location = temp_dropoff_insertion->node_index;
-					if (temp_dropoff_insertion->is_pickup)
-						++occupancy_after_pickup;
-					else if (temp_dropoff_insertion->is_dropoff)
-						--occupancy_after_pickup;
-
-					//if there cannot be a better offer from this dropoff forward, stop
-					if (temp_time_for_dropoff + n.get_network_distance(temp_location, destination) / velocity > best_offer.dropoff_time + MACRO_EPSILON)
-						break;
-					//if the customer cannot be in the bus due to limited capacity, stop
-					if (capacity >= 0 && occupancy_after_pickup > capacity)
-						break;
+					//later dropoffs can use this pickup
+					update_best_pickup(best_pickup, has_best_pickup, pickup);
+					if (pickup.delay == 0)
+						update_best_pickup(best_pickup_without_delay, has_best_pickup_without_delay, pickup);
+					else if (pickup.delay <= MACRO_EPSILON)
+						pickups_with_negligible_delay.push_back(pickup);
 				}
 
-				//special case: drop off after all other stuff (pick up before)
-				//no need to check delay, since no customer is delayed by drop off
-				//if temp_dropoff_insertion is not at the end, the iteration stopped somewhere, because this dropoff is not possible or cannot be better
-				if (temp_dropoff_insertion == assigned_stops.end())
+				//advance to the k-th stop
+				temp_time += n.get_network_distance(temp_location, stop_nodes[k]) / velocity;
+				temp_location = stop_nodes[k];
+
+				//make sure nothing broke
+				assert(occupancy_before_stop[k + 1] >= 0 && (capacity < 0 || occupancy_before_stop[k + 1] <= capacity));
+
+				//if there cannot be a better offer from the next pickup forward, stop trying pickups
+				//(with a dropoff right after the pickup, or after later stops: if the pickup may delay the stops, these are not bounded by the drive via the pickup)
+				if (try_pickups && temp_time + n.get_network_distance(temp_location, origin) / velocity + n.get_network_distance(origin, destination) / velocity > earliest_dropoff + MACRO_EPSILON &&
+					(!pickups_may_delay_stops || earliest_later_dropoff[k + 2] > earliest_dropoff + MACRO_EPSILON))
 				{
-					dropoff_time = temp_time_for_dropoff + n.get_network_distance(temp_location, destination) / velocity;
-
-					//if the drop off at the end is a better offer
-					if (dropoff_time < best_offer.dropoff_time - MACRO_EPSILON ||
-						(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && pickup_time > best_offer.pickup_time + MACRO_EPSILON) ||
-						(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy > best_offer.best_transporter->get_occupancy())) ||
-						(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy == best_offer.best_transporter->get_occupancy()))
-						)
-					{
-						best_offer.transporter_index = index;
-						best_offer.best_transporter = this;
-						best_offer.pickup_insertion = temp_pickup_insertion;
-						best_offer.dropoff_insertion = assigned_stops.end();
-						best_offer.pickup_time = pickup_time;
-						best_offer.dropoff_time = dropoff_time;
-						best_offer.is_better_offer = true;
-					}
+					try_pickups = false;
+					COUNT_DISPATCH_WORK(pickup_scan_exits, 1);
+				}
+
+				//no pickup so far can be used for later dropoffs, if the customer does not fit
+				if (!customer_fits)
+				{
+					has_best_pickup = false;
+					has_best_pickup_without_delay = false;
+					pickups_with_negligible_delay.clear();
 				}
 			}
+			COUNT_DISPATCH_WORK(delay_check_iterations, k);
 
-			//advance location, occupancy etc. to check the next stop for pickup
-			temp_time_for_pickup += n.get_network_distance(temp_location_for_pickup, temp_pickup_insertion->node_index) / velocity;
-			temp_location_for_pickup = temp_pickup_insertion->node_index;
-			if (temp_pickup_insertion->is_pickup)
-				++occupancy_before_pickup;
-			else if (temp_pickup_insertion->is_dropoff)
-				--occupancy_before_pickup;
+			//drop off at the end of the schedule (pick up before)
+			if (has_best_pickup)
+				consider_insertion(best_pickup, number_of_stops, dropoff_times[number_of_stops], best_pickup.delay + dropoff_detours[number_of_stops]);
 
-			//make sure nothing broke
-			assert(occupancy_before_pickup >= 0 && (capacity < 0 || occupancy_before_pickup <= capacity));
+			//the pickup at the end of the schedule cannot lead to a better offer, if no further pickups are tried
+			try_pickup_at_end = try_pickups;
+		}
+		else {
+			//all pairs of pickup and dropoff positions
+			for (k = 0; k < number_of_stops; ++k)
+			{
+				pickup_candidate pickup = { 0, 0, 0 };
+				if (k < max_pickup_positions && try_pickup(k, temp_time, temp_location, pickup))
+				{
+					//drop off immediately after pickup, before going to the k-th stop
+					double delay_from_dropoff;
+					if (try_immediate_dropoff(k, temp_location, pickup, delay_from_dropoff))
+						consider_insertion(pickup, k, dropoff_time, delay_from_dropoff);
 
-			//if there cannot be a better offer from this pickup forward, stop
-			if (temp_time_for_pickup + n.get_network_distance(temp_location_for_pickup, origin) / velocity + n.get_network_distance(origin, destination) / velocity > best_offer.dropoff_time + MACRO_EPSILON)
-				break;
+					//drop off at a later position, as long as the customer fits into the bus when passing the stops in between
+					for (ULL later_position = k + 1; later_position <= number_of_stops; ++later_position)
+					{
+						COUNT_DISPATCH_WORK(delay_check_iterations, 1);
+						if (limited_capacity && capacity >= 0 && occupancy_before_stop[later_position] + 1 > capacity)
+							break;
+						if (dropoff_within_slack[later_position] || pickup.delay + dropoff_delays[later_position] <= MACRO_EPSILON)
+							consider_insertion(pickup, later_position, dropoff_times[later_position], pickup.delay + dropoff_detours[later_position]);
+					}
+				}
+
+				//advance to the k-th stop
+				temp_time += n.get_network_distance(temp_location, stop_nodes[k]) / velocity;
+				temp_location = stop_nodes[k];
+			}
+			COUNT_DISPATCH_WORK(delay_check_iterations, number_of_stops);
 		}
 
-		//special case: drop off after all other stuff (pick up before)
-		//no need to check delay, since no customer is delayed
-		//if temp_pickup_insertion is not at the end, the iteration stopped somewhere, because this pickup is not possible or cannot be better
-		pickup_time = temp_time_for_pickup + n.get_network_distance(temp_location_for_pickup, origin) / velocity;
-		if (temp_pickup_insertion == assigned_stops.end())
+		//pick up and drop off at the end of the schedule, no need to check delay, since no customer is delayed
+		if (try_pickup_at_end)
 		{
+			COUNT_DISPATCH_WORK(pickup_positions, 1);
+			pickup_time = temp_time + n.get_network_distance(temp_location, origin) / velocity;
 			dropoff_time = pickup_time + n.get_network_distance(origin, destination) / velocity;
+			pickup_candidate pickup_at_end = { number_of_stops, pickup_time, 0 };
+			consider_insertion(pickup_at_end, number_of_stops, dropoff_time, n.get_network_distance(temp_location, origin) / velocity + n.get_network_distance(origin, destination) / velocity);
+		}
 
-			if (dropoff_time < best_offer.dropoff_time - MACRO_EPSILON ||
-				(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && pickup_time > best_offer.pickup_time + MACRO_EPSILON) ||
-				(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy > best_offer.best_transporter->get_occupancy())) ||
-				(abs(dropoff_time - best_offer.dropoff_time) <= MACRO_EPSILON && abs(pickup_time - best_offer.pickup_time) <= MACRO_EPSILON && (best_offer.best_transporter != NULL && occupancy == best_offer.best_transporter->get_occupancy()))
-				)
-			{
-				best_offer.transporter_index = index;
-				best_offer.best_transporter = this;
-				best_offer.pickup_insertion = assigned_stops.end();
-				best_offer.dropoff_insertion = assigned_stops.end();
-				best_offer.pickup_time = pickup_time;
-				best_offer.dropoff_time = dropoff_time;
-				best_offer.is_better_offer = true;
-			}
+		//if the best insertion is a better offer, remember
+		if (found_insertion && improves_best_offer(found_pickup_time, found_dropoff_time, found_added_vehicle_time))
+		{
+			best_offer.transporter_index = index;
+			best_offer.best_transporter = this;
+			best_offer.pickup_insertion = found_pickup_position;
+			best_offer.dropoff_insertion = found_dropoff_position;
+			best_offer.pickup_time = found_pickup_time;
+			best_offer.dropoff_time = found_dropoff_time;
+			best_offer.added_vehicle_time = found_added_vehicle_time;
+			best_offer.ordering = 0;
+			best_offer.is_better_offer = true;
 		}
 	}
+	else
+		COUNT_DISPATCH_WORK(bound_exits, 1);
 
 	//decide if best offer of this bus is better than the current best offer
-	if (best_offer.dropoff_time < current_best_offer.dropoff_time ||
-		(abs(best_offer.dropoff_time - current_best_offer.dropoff_time) <= MACRO_EPSILON && best_offer.pickup_time > current_best_offer.pickup_time + MACRO_EPSILON)
+	//(an equally good offer of a bus with at least the same occupancy only counts if its cost is lower, even if by less than epsilon)
+	if (best_offer.best_transporter != NULL && (current_best_offer.best_transporter == NULL ||
+		compare::has_lower_cost(request_time, best_offer.pickup_time, best_offer.dropoff_time, best_offer.added_vehicle_time, current_best_offer.pickup_time, current_best_offer.dropoff_time, current_best_offer.added_vehicle_time) ||
+		compare::is_better(request_time, best_offer.pickup_time, best_offer.dropoff_time, best_offer.added_vehicle_time, current_best_offer.pickup_time, current_best_offer.dropoff_time, current_best_offer.added_vehicle_time))
 		)
 		best_offer.is_better_offer = true;
 	else
@@ -490,14 +665,14 @@ offer transporter::best_offer(ULL param_origin, ULL param_destination, double pa
 }
 
 //assign a customer based on the request and the offer made
-double transporter::assign_customer(double assignment_time, customer c, offer& o, traffic_network &n)
+double transporter::assign_customer(double assignment_time, customer_handle c, offer& o, customer_pool& customers, traffic_network &n)
 {
-	//make sure its the correct transporter!
-	assert(o.transporter_index == index);
+	//make sure its the correct transporter and the offer refers to the current schedule!
+	assert(o.transporter_index == index && o.schedule_version == schedule_version);
 
 	//assign the customer to the transporter
-	assigned_customers.push_front(c);
-	std::list<customer>::iterator c_it = assigned_customers.begin();
+	++number_of_assigned_customers;
+	customer& new_customer = customers.get_customer(c);
 
 	//if the transporter was idle, count time between stops from now (instead of from arrival at the last stop)
 	if (idle)
@@ -506,12 +681,34 @@ double transporter::assign_customer(double assignment_time, customer c, offer& o
 		time_of_last_stop = assignment_time;
 	}
 
+	double next_event_time = -1;
+
+	//with a kinetic tree, the offer may refer to another ordering of the stops, which becomes the schedule
+	bool first_stop_changed = false;
+	if (use_kinetic_tree)
+	{
+		if (o.ordering != 0)
+		{
+			static thread_local std::vector<ULL> ordering;
+			static thread_local std::vector<stop> reordered_stops;
+			schedule_tree.get_ordering(o.ordering, ordering);
+
+			reordered_stops.clear();
+			for (ULL k : ordering)
+				reordered_stops.push_back(assigned_stops[k]);
+			first_stop_changed = (ordering.front() != 0);
+			assigned_stops.swap(reordered_stops);
+		}
+		schedule_tree.insert_request(o.ordering, o.pickup_insertion, o.dropoff_insertion);
+	}
+
 	//if pickup right now (before the next stop), plan a new route to the new stop
-	if (assigned_stops.empty() || o.pickup_insertion == assigned_stops.begin())  //if empty, pickup insertion is end(), which is equal to begin() for empty lists
+	//(the dropoff insertion refers to the stops before inserting the pickup, which moves all later stops back by one)
+	if (o.pickup_insertion == 0)  //if empty, pickup insertion is the end, which is the first position
 	{
 		//insert the assigned stops
-		assigned_stops.insert(o.pickup_insertion, stop(c.get_origin(), c_it, o.pickup_time, true, false, 0));
-		assigned_stops.insert(o.dropoff_insertion, stop(c.get_destination(), c_it, o.dropoff_time, false, true, 0));
+		assigned_stops.insert(assigned_stops.begin() + o.pickup_insertion, stop(new_customer.get_origin(), c, o.pickup_time, new_customer.get_allowed_pickup_delay(), pickup_stop, 0));
+		assigned_stops.insert(assigned_stops.begin() + (o.dropoff_insertion + 1), stop(new_customer.get_destination(), c, o.dropoff_time, new_customer.get_allowed_dropoff_delay(), dropoff_stop, 0));
 
 		//plan the new route
 
@@ -519,48 +716,305 @@ double transporter::assign_customer(double assignment_time, customer c, offer& o
 		{
 			//make sure bus was idle if there is no current route
 			assert(idle);
-			//plan route from the current location
-			return(new_route(n.find_shortest_path(current_location, c.get_origin(), c.get_request_time(), velocity)));
+			//plan route from the current location (starting when the customer is assigned)
+			next_event_time = new_route(n.find_shortest_path(current_location, new_customer.get_origin(), assignment_time, velocity));
 		}
 		else
 		{
 			//plan route from the next node on the current route
-			new_route(n.find_shortest_path(current_location, c.get_origin(), current_time, velocity));
+			new_route(n.find_shortest_path(current_location, new_customer.get_origin(), current_time, velocity));
 			//do NOT add a new event (bus is still driving to the next node on the route as in the old route)
-			return(-1);
 		}
 
 	}
 	else {	//else, simply insert the stops in the list of scheduled stops, the bus will continue its current route
 		assert(!assigned_stops.empty());
 
-		assigned_stops.insert(o.pickup_insertion, stop(c.get_origin(), c_it, o.pickup_time, true, false, 0));
-		assigned_stops.insert(o.dropoff_insertion, stop(c.get_destination(), c_it, o.dropoff_time, false, true, 0));
+		assigned_stops.insert(assigned_stops.begin() + o.pickup_insertion, stop(new_customer.get_origin(), c, o.pickup_time, new_customer.get_allowed_pickup_delay(), pickup_stop, 0));
+		assigned_stops.insert(assigned_stops.begin() + (o.dropoff_insertion + 1), stop(new_customer.get_destination(), c, o.dropoff_time, new_customer.get_allowed_dropoff_delay(), dropoff_stop, 0));
+
+		//the reordered schedule starts with another stop, drive there from the next node on the current route
+		if (first_stop_changed)
+			new_route(n.find_shortest_path(current_location, assigned_stops.front().node_index, current_time, velocity));
+	}
+
+	//later stops may be delayed by the insertion, update planned times and remaining slack
+	update_schedule(n);
+
+	return(next_event_time);
+}
+
+//recompute the schedule data of the assigned stops from the next node on the route
+//(the planned arrival times are accumulated in the same order as in best_offer, so the O(1) checks there agree with walking the stops)
+void transporter::update_schedule(traffic_network &n)
+{
+	++schedule_version;
+
+	ULL number_of_stops = assigned_stops.size();
+	stop_nodes.resize(number_of_stops);
+	planned_arrival_times.resize(number_of_stops);
+	remaining_slack.resize(number_of_stops + 1);
+	occupancy_before_stop.resize(number_of_stops + 1);
+
+	//planned arrival times and occupancy along the schedule
+	double temp_time = current_time;
+	ULL temp_location = current_location;
+	LL temp_occupancy = occupancy;
+	for (ULL k = 0; k < number_of_stops; ++k)
+	{
+		stop& s = assigned_stops[k];
+
+		temp_time += n.get_network_distance(temp_location, s.node_index) / velocity;
+		temp_location = s.node_index;
+
+		stop_nodes[k] = s.node_index;
+		planned_arrival_times[k] = temp_time;
+		occupancy_before_stop[k] = temp_occupancy;
+
+		if (s.is_pickup())
+			++temp_occupancy;
+		else if (s.is_dropoff())
+			--temp_occupancy;
+	}
+	occupancy_before_stop[number_of_stops] = temp_occupancy;
+
+	//remaining slack, backwards from the end of the schedule
+	//a stop may arrive up to (allowed delay factor) x (remaining time until the promised time) after the current time
+	remaining_slack[number_of_stops] = std::numeric_limits<double>::infinity();
+	for (ULL k = number_of_stops; k-- > 0; )
+	{
+		stop& s = assigned_stops[k];
+
+		double slack = std::numeric_limits<double>::infinity();
+		if (s.is_pickup() || s.is_dropoff())
+			slack = current_time + s.allowed_delay * (s.promised_time - current_time + MACRO_EPSILON) - planned_arrival_times[k];
+
+		remaining_slack[k] = std::min(slack, remaining_slack[k + 1]);
+	}
+
+	//kinetic tree: a stop may arrive until its latest allowed arrival, or within epsilon of its planned arrival (as in best_offer)
+	if (use_kinetic_tree)
+	{
+		stop_occupancy_changes.resize(number_of_stops);
+		stop_deadlines.resize(number_of_stops);
+		for (ULL k = 0; k < number_of_stops; ++k)
+		{
+			stop& s = assigned_stops[k];
+
+			stop_occupancy_changes[k] = (s.is_pickup() ? 1 : (s.is_dropoff() ? -1 : 0));
+			stop_deadlines[k] = std::numeric_limits<double>::infinity();
+			if (s.is_pickup() || s.is_dropoff())
+				stop_deadlines[k] = std::max(planned_arrival_times[k] + MACRO_EPSILON, current_time + s.allowed_delay * (s.promised_time - current_time + MACRO_EPSILON));
+		}
+
+		schedule_tree.update(stop_nodes, stop_occupancy_changes, stop_deadlines, current_location, current_time, velocity, occupancy, capacity, n);
+	}
+}
+
+//keep a kinetic tree of all feasible orderings of the assigned stops (starting with the current schedule)
+void transporter::enable_kinetic_tree(ULL param_max_orderings, traffic_network &n)
+{
+	use_kinetic_tree = true;
+	schedule_tree.set_max_orderings(param_max_orderings);
+	schedule_tree.reset(assigned_stops.size());
+	update_schedule(n);
+}
+
+//copy the assigned stops and the state of the transporter for the schedule optimizer
+//deadlines as for the kinetic tree: the latest allowed arrival, or within epsilon of the planned arrival
+void transporter::get_schedule_snapshot(schedule_snapshot& s)
+{
+	ULL number_of_stops = assigned_stops.size();
+
+	s.transporter_index = index;
+	s.location = current_location;
+	s.time = current_time;
+	s.velocity = velocity;
+	s.occupancy = occupancy;
+	s.capacity = capacity;
+
+	s.stop_nodes.assign(stop_nodes.begin(), stop_nodes.end());
+	s.occupancy_changes.resize(number_of_stops);
+	s.deadlines.resize(number_of_stops);
+	s.pickup_of_stop.assign(number_of_stops, -1);
+	for (ULL k = 0; k < number_of_stops; ++k)
+	{
+		stop& st = assigned_stops[k];
+
+		s.occupancy_changes[k] = (st.is_pickup() ? 1 : (st.is_dropoff() ? -1 : 0));
+		s.deadlines[k] = std::numeric_limits<double>::infinity();
+		if (st.is_pickup() || st.is_dropoff())
+			s.deadlines[k] = std::max(planned_arrival_times[k] + MACRO_EPSILON, current_time + st.allowed_delay * (st.promised_time - current_time + MACRO_EPSILON));
+
+		if (st.is_dropoff())
+		{
+			for (ULL j = 0; j < k; ++j)
+			{
+				if (assigned_stops[j].is_pickup() && assigned_stops[j].c == st.c)
+					s.pickup_of_stop[k] = j;
+			}
+		}
+	}
+
+	s.improved = false;
+	s.ordering.clear();
+}
+
+//follow another ordering of the assigned stops (positions in the current schedule, as in the snapshot)
+//if the first stop changes, drive there from the next node on the current route (as for an insertion before the first stop)
+void transporter::reorder_stops(const std::vector<ULL>& ordering, traffic_network &n)
+{
+	assert(ordering.size() == assigned_stops.size() && !assigned_stops.empty());
+
+	static thread_local std::vector<stop> reordered_stops;
+	reordered_stops.clear();
+	for (ULL k : ordering)
+		reordered_stops.push_back(assigned_stops[k]);
+	assigned_stops.swap(reordered_stops);
+
+	if (ordering.front() != 0)
+		new_route(n.find_shortest_path(current_location, assigned_stops.front().node_index, current_time, velocity));
+
+	//the kinetic tree only knows the orderings of the previous schedule
+	if (use_kinetic_tree)
+		schedule_tree.reset(assigned_stops.size());
+
+	update_schedule(n);
+}
+
+//arrival at the last stop if the pickup and dropoff of the customer were removed, compared to the current schedule (accumulated as in update_schedule)
+double transporter::removal_saving(customer_handle c, traffic_network &n)
+{
+	assert(!assigned_stops.empty());
+
+	double temp_time = current_time;
+	ULL temp_location = current_location;
+	for (stop& s : assigned_stops)
+	{
+		if (s.c == c && (s.is_pickup() || s.is_dropoff()))
+			continue;
+
+		temp_time += n.get_network_distance(temp_location, s.node_index) / velocity;
+		temp_location = s.node_index;
+	}
+
+	return(planned_arrival_times.back() - temp_time);
+}
+
+//remove the pickup and dropoff of a customer that is not yet picked up, no other stop is delayed
+//if the pickup was the next stop, drive to the new next stop from the next node on the current route
+void transporter::remove_customer(customer_handle c, traffic_network &n)
+{
+	assert(assigned_stops.size() > 2);
+	assert(std::find_if(assigned_stops.begin(), assigned_stops.end(), [c](const stop& s) { return(s.c == c && s.is_pickup()); }) != assigned_stops.end());
+
+	bool first_stop_removed = (assigned_stops.front().c == c && assigned_stops.front().is_pickup());
+	assigned_stops.erase(std::remove_if(assigned_stops.begin(), assigned_stops.end(), [c](const stop& s) { return(s.c == c && (s.is_pickup() || s.is_dropoff())); }), assigned_stops.end());
+	--number_of_assigned_customers;
+
+	if (first_stop_removed)
+		new_route(n.find_shortest_path(current_location, assigned_stops.front().node_index, current_time, velocity));
+
+	//the kinetic tree only knows the orderings of the previous schedule
+	if (use_kinetic_tree)
+		schedule_tree.reset(assigned_stops.size());
 
-		return(-1);
+	update_schedule(n);
+}
+
+//offer of the idle transporter given its pickup and dropoff time and the additional driving time for the request (see the idle case of best_offer)
+template<class objective>
+offer transporter::idle_offer(double param_request_time, double pickup_time, double dropoff_time, double added_vehicle_time, offer& current_best_offer)
+{
+	offer best_offer = current_best_offer;
+	best_offer.is_better_offer = false;
+
+	assert(idle);
+	COUNT_DISPATCH_WORK(transporters_evaluated, 1);
+
+	//admission limits (see best_offer)
+	if (!has_room_for_customer() || pickup_time - param_request_time > max_wait + MACRO_EPSILON)
+		return(best_offer);
+
+	//new stops would be inserted at the end of the scheduled stop (since none are planned, the bus is idle), if better offer, remember
+	if (improves_offer<objective>(param_request_time, pickup_time, dropoff_time, added_vehicle_time, best_offer))
+	{
+		best_offer.transporter_index = index;
+		best_offer.best_transporter = this;
+		best_offer.pickup_insertion = assigned_stops.size();
+		best_offer.dropoff_insertion = assigned_stops.size();
+		best_offer.pickup_time = pickup_time;
+		best_offer.dropoff_time = dropoff_time;
+		best_offer.added_vehicle_time = added_vehicle_time;
+		best_offer.ordering = 0;
+		best_offer.schedule_version = schedule_version;
+		best_offer.is_better_offer = true;
 	}
 
+	return(best_offer);
+}
+
+//only insert into the current schedule
+void transporter::disable_kinetic_tree()
+{
+	use_kinetic_tree = false;
+	schedule_tree.reset(0);
+}
+
+//set the admission limits (infinity and max: no limit), they are kept when the transporter is reset
+void transporter::set_admission_limits(double param_max_wait, ULL param_max_planned_stops)
+{
+	assert(param_max_wait >= 0 && param_max_planned_stops >= 2);
+
+	max_wait = param_max_wait;
+	max_planned_stops = param_max_planned_stops;
 }
 
 
 
-//initialize capacity and velocity of transporters depending on their type
+//instantiate the dispatcher for all objectives (see dispatch_objective.h)
+template offer transporter::best_offer<earliest_dropoff_objective>(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer, ULL max_pickup_positions);
+template offer transporter::best_offer<minimal_wait_objective>(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer, ULL max_pickup_positions);
+template offer transporter::best_offer<minimal_added_vehicle_time_objective>(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer, ULL max_pickup_positions);
+template offer transporter::best_offer<default_weighted_cost_objective>(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer, ULL max_pickup_positions);
+template offer transporter::idle_offer<earliest_dropoff_objective>(double param_request_time, double pickup_time, double dropoff_time, double added_vehicle_time, offer& current_best_offer);
+template offer transporter::idle_offer<minimal_wait_objective>(double param_request_time, double pickup_time, double dropoff_time, double added_vehicle_time, offer& current_best_offer);
+template offer transporter::idle_offer<minimal_added_vehicle_time_objective>(double param_request_time, double pickup_time, double dropoff_time, double added_vehicle_time, offer& current_best_offer);
+template offer transporter::idle_offer<default_weighted_cost_objective>(double param_request_time, double pickup_time, double dropoff_time, double added_vehicle_time, offer& current_best_offer);
+
+//initialize capacity, velocity and allowed delays of transporters depending on their type (from the table of fleet types, if set)
 void transporter::init_by_type()
 {
 	//default behavior:
 	//	velocity  = 1  (determines the timescale of the system, without loss of generality)
 	//  capacity = -1  (negative values indicate infinite capacity)
-	if (type == 0)
+	//  no delay of the customers
+	if (fleet_types != NULL)
 	{
-		velocity = 1;
-		capacity = -1;
+		const transporter_type& t = fleet_types->get_type(type);
+		velocity = t.velocity;
+		capacity = t.capacity;
+		allowed_pickup_delay = t.allowed_pickup_delay;
+		allowed_dropoff_delay = t.allowed_dropoff_delay;
 	}
 	else {
 		velocity = 1;
 		capacity = -1;
+		allowed_pickup_delay = 0;
+		allowed_dropoff_delay = 0;
 	}
 }
 
+//take the parameters of the types from the table (NULL: default parameters), the transporter must not have any stops
+void transporter::set_fleet_types(const fleet_type_table* param_fleet_types, ULL param_type)
+{
+	assert(assigned_stops.empty() && (param_fleet_types == NULL || param_type < param_fleet_types->size()));
+
+	fleet_types = param_fleet_types;
+	type = param_type;
+	init_by_type();
+}
+
 //handle events that are not pickup or delivery (not used so far, do nothing and do return a negative time --> no new event)
 //return the time of the next event for this bus
 double transporter::handle_event_by_type(double time, traffic_network& n, stop& current_stop)
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <deque>
 #include <list>
+#include <vector>
+#include <limits>
 
 #ifndef _INTEGER_TYPES
 #define ULL uint64_t
@@ -20,31 +22,51 @@
 #include "measurement_collector.h"
 #include "customer.h"
 #include "traffic_network.h"
+#include "dispatch_objective.h"
+#include "kinetic_tree.h"
+#include "schedule_optimizer.h"
+#include "dispatch_instrumentation.h"
+#include "fleet_type_table.h"
 
 class measurement_collector;
 class customer;
+class customer_pool;
 class transporter;
 
-struct stop
+//kind of a stop (one byte)
+enum stop_kind : uint8_t
 {
-	ULL node_index;
-
-	std::list<customer>::iterator c_it;
-	double planned_time;
-
-	bool is_pickup;
-	bool is_dropoff;
+	other_stop = 0,
+	pickup_stop = 1,
+	dropoff_stop = 2
+};
 
-	ULL type;
+//compact stop record (32 bytes), everything needed to check delays is copied from the customer on insertion
+//the latest allowed arrival at the stop is current time + allowed_delay * (promised_time - current time)
+struct stop
+{
+	uint32_t node_index;
+	customer_handle c;
+
+	double promised_time;		//offered pickup or dropoff time of the customer
+	double allowed_delay;		//allowed delay factor of the customer for this stop
+
+	uint8_t kind;				//stop_kind
+	uint8_t type;				//for other stops, see handle_event_by_type
+
+	stop(ULL param_node_index, customer_handle param_customer, double param_promised_time, double param_allowed_delay, stop_kind param_kind, ULL param_type)
+		: node_index((uint32_t)param_node_index),
+		c(param_customer),
+		promised_time(param_promised_time),
+		allowed_delay(param_allowed_delay),
+		kind(param_kind),
+		type((uint8_t)param_type)
+	{
+		assert(param_node_index <= std::numeric_limits<uint32_t>::max() && param_type <= std::numeric_limits<uint8_t>::max());
+	};
 
-	stop(ULL param_node_index, std::list<customer>::iterator param_customer, double param_time, bool param_is_pickup, bool param_is_dropoff, ULL param_type)
-		: node_index(param_node_index),
-		c_it(param_customer),
-		planned_time(param_time),
-		is_pickup(param_is_pickup),
-		is_dropoff(param_is_dropoff),
-		type(param_type)
-	{};
+	bool is_pickup() const { return(kind == pickup_stop); }
+	bool is_dropoff() const { return(kind == dropoff_stop); }
 };
 
 struct offer
@@ -53,24 +75,33 @@ struct offer
 	transporter* best_transporter;
 
 	double pickup_time;
-	std::list< stop >::iterator pickup_insertion;
+	ULL pickup_insertion;		//index of the stop before which the pickup is inserted (number of stops: at the end)
 
 	double dropoff_time;
-	std::list< stop >::iterator dropoff_insertion;
+	ULL dropoff_insertion;		//index of the stop before which the dropoff is inserted (in the schedule without the pickup, same index as the pickup: right after the pickup)
+
+	double added_vehicle_time;	//additional driving time of the transporter
+
+	ULL ordering;				//kinetic tree: ordering of the stops the insertions refer to (0: the current schedule)
+
+	ULL schedule_version;		//version of the schedule of the transporter the insertions refer to (see transporter::get_schedule_version)
 
 	bool is_better_offer;
 
-	offer(ULL param_transporter_index, transporter* param_best_transporter, double param_pickup_time, std::list< stop >::iterator param_pickup_insertion, double param_dropoff_time, std::list< stop >::iterator param_dropoff_insertion)
+	offer(ULL param_transporter_index, transporter* param_best_transporter, double param_pickup_time, ULL param_pickup_insertion, double param_dropoff_time, ULL param_dropoff_insertion)
 		: transporter_index(param_transporter_index),
 		best_transporter(param_best_transporter),
 		pickup_time(param_pickup_time),
 		pickup_insertion(param_pickup_insertion),
 		dropoff_time(param_dropoff_time),
 		dropoff_insertion(param_dropoff_insertion),
+		added_vehicle_time(0),
+		ordering(0),
+		schedule_version(0),
 		is_better_offer(false)
 	{};
 
-	offer() : dropoff_time(std::numeric_limits<ULL>::max()) {};
+	offer() : transporter_index(0), best_transporter(NULL), pickup_time(0), pickup_insertion(0), dropoff_time(std::numeric_limits<ULL>::max()), dropoff_insertion(0), added_vehicle_time(0), ordering(0), schedule_version(0), is_better_offer(false) {};
 };
 
 class transporter
@@ -79,50 +110,84 @@ public:
 	transporter(ULL param_index, ULL param_location, ULL param_type, std::mt19937_64 param_random_generator);
 	void reset(ULL param_index, ULL param_location, ULL param_type);
 	void init_by_type();
+	void set_fleet_types(const fleet_type_table* param_fleet_types, ULL param_type);
 	virtual ~transporter();
 
 	ULL get_index() { return(index); }
 	LL get_capacity() { return(capacity); }
 	double get_velocity() { return(velocity); }
 	ULL get_type() { return(type); }
+	double get_allowed_pickup_delay() { return(allowed_pickup_delay); }
+	double get_allowed_dropoff_delay() { return(allowed_dropoff_delay); }
 
 	ULL get_current_location() { return(current_location); }
 	double get_current_time() { return(current_time); }
 
 	LL get_occupancy() { return(occupancy); }
-	LL get_number_of_scheduled_customers() { return(assigned_customers.size()); }
+	LL get_number_of_scheduled_customers() { return(number_of_assigned_customers); }
 	bool is_idle() { return(idle); }
 
 	std::pair<ULL, double> get_next_route_node() { return(current_route.front()); }	//should always be the same as current position and time (!!!)
 
 	ULL get_number_of_planned_stops() {
-		assert(assigned_stops.size() == 2 * assigned_customers.size() - occupancy);
+		assert((LL)assigned_stops.size() == 2 * number_of_assigned_customers - occupancy);
 		return(assigned_stops.size());
 	};
 	double get_planned_time_horizon(double time) {
 		if (assigned_stops.empty())
 			return(0);
 		else
-			return(assigned_stops.rbegin()->planned_time - time);
+			return(planned_arrival_times.back() - time);
 	}
-	std::list< stop >::iterator get_next_stop() { return(assigned_stops.begin()); }
-	std::list< stop >::iterator no_stop() { return(assigned_stops.end()); }
+	std::vector< stop >::iterator get_next_stop() { return(assigned_stops.begin()); }
+	std::vector< stop >::iterator no_stop() { return(assigned_stops.end()); }
 
-	double execute_event(double time, traffic_network& n, measurement_collector& m, ULL& total_serviced_requests, bool do_measurement);	//execute event, returns next event time (if any)
+	double execute_event(double time, traffic_network& n, customer_pool& customers, measurement_collector& m, ULL& total_serviced_requests, bool do_measurement);	//execute event, returns next event time (if any)
 	double handle_event_by_type(double time, traffic_network& n, stop& current_stop);
 	double new_route(std::deque< std::pair<ULL, double> > param_new_route);
 
-	offer best_offer(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer);
-	double assign_customer(double assignment_time, customer c, offer& o, traffic_network &n);
+	double dropoff_time_bound(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n);	//no offer of this transporter can have an earlier dropoff time
+	template<class objective = earliest_dropoff_objective>
+	offer best_offer(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer, ULL max_pickup_positions = std::numeric_limits<ULL>::max());	//pickups only before the first stops (approximate dispatch) or at the end
+	template<class objective = earliest_dropoff_objective>
+	offer idle_offer(double param_request_time, double pickup_time, double dropoff_time, double added_vehicle_time, offer& current_best_offer);	//offer of an idle transporter with given times (same as best_offer, for idle transporters evaluated together)
+	double assign_customer(double assignment_time, customer_handle c, offer& o, customer_pool& customers, traffic_network &n);
+	void update_schedule(traffic_network &n);	//recompute planned arrival times, remaining slack and occupancy of the assigned stops
+	ULL get_schedule_version() { return(schedule_version); }	//changes whenever the schedule or the position changes, an offer can only be assigned with the version it was made for
+
+	//keep all feasible orderings of the assigned stops (at most max orderings), offers may reorder the schedule (see kinetic_tree.h)
+	void enable_kinetic_tree(ULL param_max_orderings, traffic_network &n);
+	void disable_kinetic_tree();
+	ULL get_number_of_feasible_orderings() { return(use_kinetic_tree ? schedule_tree.get_number_of_orderings() : 1); }
+
+	//re-optimization of the order of the assigned stops (see schedule_optimizer.h), the ordering must refer to the stops of the snapshot
+	void get_schedule_snapshot(schedule_snapshot& s);
+	void reorder_stops(const std::vector<ULL>& ordering, traffic_network &n);
+
+	//customers that are not yet picked up can be moved to another transporter (only if other stops remain, the transporter does not become idle on the way)
+	double removal_saving(customer_handle c, traffic_network &n);	//earlier arrival at the last stop without the stops of the customer
+	void remove_customer(customer_handle c, traffic_network &n);
+
+	//admission control: no offer if the origin cannot be reached within the maximal wait or the schedule has no room for two more stops (see admission_policy.h)
+	void set_admission_limits(double param_max_wait, ULL param_max_planned_stops);
+	bool has_room_for_customer() { return(assigned_stops.size() + 2 <= max_planned_stops); }
 
 protected:
 
 private:
+	template<class objective, bool limited_capacity>
+	offer best_offer_by_capacity(ULL param_origin, ULL param_destination, double param_request_time, traffic_network &n, offer& current_best_offer, ULL max_pickup_positions);
+	template<class objective>
+	bool improves_offer(double request_time, double pickup_time, double dropoff_time, double added_vehicle_time, const offer& best);
+
 	ULL index;
 
 	LL capacity;		//negative value --> infinite capacity
 	double velocity;
 	ULL type;
+	double allowed_pickup_delay;	//of the customers of this transporter
+	double allowed_dropoff_delay;
+	const fleet_type_table* fleet_types;	//parameters of the types (NULL: default parameters, see init_by_type)
 	//add arbitrary parameters how
 
 	//next node to be at and when the transporter arrives
@@ -133,12 +198,31 @@ private:
 
 
 	std::deque< std::pair<ULL, double> > current_route;	//list of nodes on the route to the next stop
-	std::list< stop > assigned_stops;
+	std::vector< stop > assigned_stops;		//contiguous, insertions only move the (few) later stops
+
+	LL number_of_assigned_customers;	//customers in customer_pool that are not yet dropped off
+
+	//schedule data per assigned stop (index k is the k-th stop in assigned_stops, index size() stands for the end of the schedule)
+	//updated whenever the stops or the position of the bus change, so that each insertion can be checked in O(1)
+	//kept in separate arrays, so that best_offer only streams through the data it needs
+	std::vector<uint32_t> stop_nodes;			//node of the stop
+	std::vector<double> planned_arrival_times;	//arrival at the stop when driving along the schedule from the next node on the route
+	std::vector<double> remaining_slack;		//minimal additional delay allowed over this and all later stops
+	std::vector<LL> occupancy_before_stop;		//occupancy of the bus when arriving at the stop
+
+	//kinetic tree of the feasible orderings of the assigned stops
+	bool use_kinetic_tree;
+	kinetic_tree schedule_tree;
+	std::vector<LL> stop_occupancy_changes;
+	std::vector<double> stop_deadlines;			//latest arrival at the stop that does not exceed the allowed delay (at least the planned arrival)
 
-	std::list<customer> assigned_customers;
+	//admission limits
+	double max_wait;
+	ULL max_planned_stops;
 
 	LL occupancy;
 	bool idle;
+	ULL schedule_version;
 
 	std::mt19937_64 &random_generator;
 };
@@ -0,0 +1,94 @@
+#include "worker_pool.h"
+
+//constructor, no additional threads (everything runs on the calling thread)
+worker_pool::worker_pool()
+{
+	task_generation = 0;
+	running_workers = 0;
+	shutting_down = false;
+}
+
+//stop and join all threads
+worker_pool::~worker_pool()
+{
+	stop_workers();
+}
+
+//(re)start the worker threads
+void worker_pool::set_number_of_threads(ULL param_number_of_threads)
+{
+	assert(param_number_of_threads > 0);
+
+	stop_workers();
+
+	shutting_down = false;
+	for (ULL thread_index = 1; thread_index < param_number_of_threads; ++thread_index)
+		workers.push_back(std::thread(&worker_pool::worker_loop, this, thread_index, task_generation));
+}
+
+//tell all threads to finish and wait for them
+void worker_pool::stop_workers()
+{
+	{
+		std::unique_lock<std::mutex> lock(pool_mutex);
+		shutting_down = true;
+	}
+	start_condition.notify_all();
+
+	for (std::thread& w : workers)
+		w.join();
+	workers.clear();
+}
+
+//run the task on all threads and wait until all are done
+void worker_pool::run(std::function<void(ULL)> task)
+{
+	if (workers.empty())
+	{
+		task(0);
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(pool_mutex);
+		current_task = task;
+		running_workers = workers.size();
+		++task_generation;
+	}
+	start_condition.notify_all();
+
+	//the calling thread does its part as well
+	task(0);
+
+	std::unique_lock<std::mutex> lock(pool_mutex);
+	done_condition.wait(lock, [this] { return(running_workers == 0); });
+}
+
+//wait for new tasks and run them until the pool shuts down
+void worker_pool::worker_loop(ULL thread_index, ULL start_generation)
+{
+	ULL last_generation = start_generation;
+	std::function<void(ULL)> task;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex);
+			start_condition.wait(lock, [this, last_generation] { return(shutting_down || task_generation != last_generation); });
+			if (shutting_down)
+				return;
+
+			last_generation = task_generation;
+			task = current_task;
+		}
+
+		task(thread_index);
+
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex);
+			--running_workers;
+			if (running_workers == 0)
+				done_condition.notify_one();
+		}
+	}
+}
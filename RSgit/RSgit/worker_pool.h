@@ -0,0 +1,49 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include <cassert>
+
+#ifndef _INTEGER_TYPES
+#define ULL uint64_t
+#define LL int64_t
+#define _INTEGER_TYPES
+#endif
+
+//fixed set of worker threads that all run the same task (e.g. on their own part of the transporters)
+//the calling thread takes part as thread 0, run() returns after all threads are done
+class worker_pool
+{
+public:
+	worker_pool();
+	virtual ~worker_pool();
+
+	void set_number_of_threads(ULL param_number_of_threads);	//including the calling thread
+	ULL get_number_of_threads() { return(workers.size() + 1); }
+
+	void run(std::function<void(ULL)> task);	//call task(thread_index) on every thread
+
+protected:
+
+private:
+	void stop_workers();
+	void worker_loop(ULL thread_index, ULL start_generation);
+
+	std::vector<std::thread> workers;
+
+	std::mutex pool_mutex;
+	std::condition_variable start_condition;
+	std::condition_variable done_condition;
+
+	std::function<void(ULL)> current_task;
+	ULL task_generation;		//incremented for every new task
+	ULL running_workers;
+	bool shutting_down;
+};
+
+#endif // WORKER_POOL_H